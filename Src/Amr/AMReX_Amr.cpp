@@ -31,6 +31,7 @@
 #include <AMReX_StateData.H>
 #include <AMReX_PlotFileUtil.H>
 #include <AMReX_Print.H>
+#include <AMReX_LArena.H>
 
 #ifdef BL_LAZY
 #include <AMReX_Lazy.H>
@@ -486,6 +487,18 @@ Amr::InitAmr ()
 
     loadbalance_max_fac = 1.5;
     pp.query("loadbalance_max_fac", loadbalance_max_fac);
+
+    // Move boxes from the current mapping instead of computing a new one,
+    // with at most this fraction of the state data of the level moving.
+    loadbalance_incremental = 0;
+    pp.query("loadbalance_incremental", loadbalance_incremental);
+
+    loadbalance_max_migration = 0.1;
+    pp.query("loadbalance_max_migration", loadbalance_max_migration);
+
+    // Cost of moving all the state data of a level, in time steps.
+    loadbalance_migration_cost = 0.;
+    pp.query("loadbalance_migration_cost", loadbalance_migration_cost);
 }
 
 int
@@ -1944,7 +1957,8 @@ Amr::timeStep (int  level,
 	    }
         }
 
-        if (max_level == 0 && loadbalance_level0_int > 0 && loadbalance_with_workestimates)
+        if (max_level == 0 && loadbalance_level0_int > 0
+            && (loadbalance_with_workestimates || loadbalance_with_measured_costs))
         {
             if (level_steps[0] == 1 || level_count[0] >= loadbalance_level0_int) {
                 LoadBalanceLevel0(time);
@@ -2051,6 +2065,9 @@ Amr::coarseTimeStep (Real stop_time)
 
     run_strt = amrex::second() ;
 
+    // Measure the costs of the grids made by init or restart.
+    UpdateBoxCosts();
+
     //
     // Compute new dt.
     //
@@ -2077,9 +2094,15 @@ Amr::coarseTimeStep (Real stop_time)
     }
 
     BL_PROFILE_REGION_START(stepName.str());
-    timeStep(0,cumtime,1,1,stop_time);
+    {
+        // Memory from The_Step_Arena() is recycled at the end of the step.
+        LArena::Scope step_scope(The_Step_Arena());
+        timeStep(0,cumtime,1,1,stop_time);
+    }
     BL_PROFILE_REGION_STOP(stepName.str());
 
+    FabArrayBase::memTraceStep(level_steps[0]);
+
     cumtime += dt_level[0];
 
     amr_level[0]->postCoarseTimeStep(cumtime);
@@ -2517,7 +2540,8 @@ Amr::regrid (int  lbase,
     grid_places(lbase,time,new_finest, new_grid_places);
 
     bool regrid_level_zero = (!initial) && (lbase == 0)
-        && ( loadbalance_with_workestimates || (new_grid_places[0] != amr_level[0]->boxArray()));
+        && ( loadbalance_with_workestimates || loadbalance_with_measured_costs
+             || (new_grid_places[0] != amr_level[0]->boxArray()));
 
     const int start = regrid_level_zero ? 0 : lbase+1;
 
@@ -2571,7 +2595,7 @@ Amr::regrid (int  lbase,
         // Construct skeleton of new level.
         //
 
-        if (loadbalance_with_workestimates && !initial) {
+        if ((loadbalance_with_workestimates || loadbalance_with_measured_costs) && !initial) {
             new_dmap[lev] = makeLoadBalanceDistributionMap(lev, time, new_grid_places[lev]);
         }
         else if (new_dmap[lev].empty()) {
@@ -2669,6 +2693,8 @@ Amr::regrid (int  lbase,
             printGridSummary(amrex::OutStream(),start,finest_level);
         }
     }
+
+    UpdateBoxCosts();
 }
 
 DistributionMapping
@@ -2683,8 +2709,9 @@ Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) con
     DistributionMapping newdm;
 
     const int work_est_type = amr_level[0]->WorkEstType();
+    BoxCosts* costs = boxCosts(lev);
 
-    if (work_est_type < 0) {
+    if (costs == nullptr && work_est_type < 0) {
         if (verbose) {
             amrex::Print() << "\nAMREX WARNING: work estimates type does not exist!\n\n";
         }
@@ -2699,13 +2726,104 @@ Amr::makeLoadBalanceDistributionMap (int lev, Real time, const BoxArray& ba) con
             dmtmp.define(ba);
         }
 
-        MultiFab workest(ba, dmtmp, 1, 0, MFInfo(), FArrayBoxFactory());
-        AmrLevel::FillPatch(*amr_level[lev], workest, 0, time, work_est_type, 0, 1, 0);
+        //
+        // The costs are either measured by the MFIter loops over the level
+        // or computed from the work estimate state.
+        //
+        MultiFab workest;
+        Vector<Real> rcost;
+        if (costs) {
+            costs->update(loadbalance_cost_smoothing);
+            rcost = costs->costsOn(ba);
+        } else {
+            workest.define(ba, dmtmp, 1, 0, MFInfo(), FArrayBoxFactory());
+            AmrLevel::FillPatch(*amr_level[lev], workest, 0, time, work_est_type, 0, 1, 0);
+        }
 
         Real navg = static_cast<Real>(ba.size()) / static_cast<Real>(ParallelDescriptor::NProcs());
         int nmax = static_cast<int>(std::max(std::round(loadbalance_max_fac*navg), std::ceil(navg)));
 
-        newdm = DistributionMapping::makeKnapSack(workest, nmax);
+        if (ba != boxArray(lev))
+        {
+            if (costs) {
+                Real eff;
+                newdm = DistributionMapping::makeKnapSack(rcost, eff, nmax);
+            } else {
+                newdm = DistributionMapping::makeKnapSack(workest, nmax);
+            }
+        }
+        else
+        {
+            //
+            // The grids are the same, so we can compare the new mapping
+            // with the current one, and keep the current one unless the
+            // time saved until the next load balance is worth the data
+            // that has to move.
+            //
+            if (!costs) {
+                LayoutData<Real> costld(ba, dmtmp);
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion())
+#endif
+                for (MFIter mfi(workest); mfi.isValid(); ++mfi) {
+                    costld[mfi] = workest[mfi].sum<RunOn::Device>(mfi.validbox(),0);
+                }
+                rcost.resize(ba.size());
+                ParallelDescriptor::GatherLayoutDataToVector(costld, rcost,
+                                                             ParallelContext::IOProcessorNumberSub());
+                ParallelDescriptor::Bcast(rcost.data(), rcost.size(),
+                                          ParallelContext::IOProcessorNumberSub());
+            }
+
+            int ncomp = 0;
+            const DescriptorList& desc_lst = AmrLevel::get_desc_lst();
+            for (int typ = 0; typ < desc_lst.size(); ++typ) {
+                ncomp += desc_lst[typ].nComp();
+            }
+            Vector<Long> bytes(ba.size());
+            Long total_bytes = 0;
+            for (int i = 0; i < ba.size(); ++i) {
+                bytes[i] = ba[i].numPts() * ncomp * static_cast<Long>(sizeof(Real));
+                total_bytes += bytes[i];
+            }
+
+            Real currentEfficiency, proposedEfficiency;
+            Long bytesMoved;
+            if (loadbalance_incremental) {
+                const Long max_bytes = static_cast<Long>(loadbalance_max_migration*total_bytes);
+                newdm = DistributionMapping::makeIncremental(dmtmp, rcost, bytes, max_bytes,
+                                                             currentEfficiency,
+                                                             proposedEfficiency, bytesMoved);
+            } else {
+                Real eff;
+                newdm = DistributionMapping::makeKnapSack(rcost, eff, nmax);
+                DistributionMapping::ComputeDistributionMappingEfficiency(dmtmp, newdm, rcost, bytes,
+                                                                          currentEfficiency,
+                                                                          proposedEfficiency,
+                                                                          bytesMoved);
+            }
+
+            // The time of a step goes as 1/efficiency.
+            const int nsteps = std::max(1, (max_level == 0) ? loadbalance_level0_int
+                                                            : regrid_int[lev]);
+            const Real gain = (proposedEfficiency > 0)
+                ? nsteps * (1. - currentEfficiency/proposedEfficiency) : Real(0.);
+            const Real cost = (total_bytes > 0)
+                ? loadbalance_migration_cost * static_cast<Real>(bytesMoved) / total_bytes : Real(0.);
+            const bool pays_off = proposedEfficiency > currentEfficiency && gain > cost;
+
+            if (verbose) {
+                amrex::Print() << "  efficiency " << currentEfficiency << " -> " << proposedEfficiency
+                               << ", " << bytesMoved << " of " << total_bytes << " bytes move,"
+                               << " gain " << gain << " vs. cost " << cost << " steps, "
+                               << (pays_off ? "switching" : "keeping the current distribution")
+                               << "\n";
+            }
+
+            if (!pays_off) {
+                newdm = dmtmp;
+            }
+        }
     }
     else
     {
@@ -2720,8 +2838,10 @@ Amr::LoadBalanceLevel0 (Real time)
 {
     BL_PROFILE("LoadBalanceLevel0()");
     const auto& dm = makeLoadBalanceDistributionMap(0, time, boxArray(0));
-    InstallNewDistributionMap(0, dm);
-    amr_level[0]->post_regrid(0,0);
+    if (dm != DistributionMap(0)) {
+        InstallNewDistributionMap(0, dm);
+        amr_level[0]->post_regrid(0,0);
+    }
 }
 
 void
@@ -2735,6 +2855,7 @@ Amr::InstallNewDistributionMap (int lev, const DistributionMapping& newdm)
 
     this->SetBoxArray(lev, amr_level[lev]->boxArray());
     this->SetDistributionMap(lev, amr_level[lev]->DistributionMap());
+    UpdateBoxCosts();
 }
 
 void
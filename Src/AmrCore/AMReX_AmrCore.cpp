@@ -2,6 +2,7 @@
 #include <algorithm>
 
 #include <AMReX_AmrCore.H>
+#include <AMReX_ParmParse.H>
 #include <AMReX_Print.H>
 
 #ifdef AMREX_PARTICLES
@@ -40,9 +41,7 @@ AmrCore::AmrCore (const RealBox& rb, int max_level_in,
 AmrCore::AmrCore (Geometry const& level_0_gome, AmrInfo const& amr_info)
     : AmrMesh(level_0_gome,amr_info)
 {
-#ifdef AMREX_PARTICLES
-    m_gdb.reset(new AmrParGDB(this));
-#endif
+    InitAmrCore();
 }
 
 AmrCore::~AmrCore ()
@@ -55,12 +54,68 @@ AmrCore::InitAmrCore ()
 #ifdef AMREX_PARTICLES
     m_gdb.reset(new AmrParGDB(this));
 #endif
+
+    ParmParse pp("amr");
+    pp.query("loadbalance_with_measured_costs", loadbalance_with_measured_costs);
+    pp.query("loadbalance_cost_region", loadbalance_cost_region);
+    pp.query("loadbalance_cost_smoothing", loadbalance_cost_smoothing);
 }
 
 void
 AmrCore::InitFromScratch (Real time)
 {
     MakeNewGrids(time);
+    UpdateBoxCosts();
+}
+
+DistributionMapping
+AmrCore::MakeDistributionMap (int lev, const BoxArray& ba)
+{
+    BoxCosts* costs = boxCosts(lev);
+    if (costs == nullptr) {
+        return DistributionMapping(ba);
+    }
+
+    costs->update(loadbalance_cost_smoothing);
+    const Vector<Real> rcost = costs->costsOn(ba);
+
+    Real eff;
+    DistributionMapping dm;
+    if (DistributionMapping::strategy() == DistributionMapping::KNAPSACK) {
+        dm = DistributionMapping::makeKnapSack(rcost, eff);
+    } else {
+        dm = DistributionMapping::makeSFC(rcost, ba, eff);
+    }
+
+    if (verbose) {
+        amrex::Print() << "Measured costs on level " << lev << ": efficiency " << eff << "\n";
+    }
+
+    return dm;
+}
+
+void
+AmrCore::UpdateBoxCosts ()
+{
+    if (!loadbalance_with_measured_costs) {
+        m_box_costs.clear();
+        return;
+    }
+
+    m_box_costs.resize(finest_level+1);
+    for (int lev = 0; lev <= finest_level; ++lev)
+    {
+        std::unique_ptr<BoxCosts>& costs = m_box_costs[lev];
+        if (costs && costs->boxArray() == grids[lev] && costs->DistributionMap() == dmap[lev]) {
+            continue;
+        }
+        std::unique_ptr<BoxCosts> old = std::move(costs);
+        costs.reset(new BoxCosts(grids[lev], dmap[lev], loadbalance_cost_region));
+        // Keep the history of the level.
+        if (old && old->numUpdates() > 0) {
+            costs->setSmoothed(old->costsOn(grids[lev]));
+        }
+    }
 }
 
 void
@@ -85,7 +140,7 @@ AmrCore::regrid (int lbase, Real time, bool)
                 DistributionMapping level_dmap = dmap[lev];
                 if (ba_changed) {
                     level_grids = new_grids[lev];
-                    level_dmap = DistributionMapping(level_grids);
+                    level_dmap = MakeDistributionMap(lev, level_grids);
                 }
                 const auto old_num_setdm = num_setdm;
                 RemakeLevel(lev, time, level_grids, level_dmap);
@@ -98,7 +153,7 @@ AmrCore::regrid (int lbase, Real time, bool)
 	}
 	else  // a new level
 	{
-            DistributionMapping new_dmap(new_grids[lev]);
+            DistributionMapping new_dmap = MakeDistributionMap(lev, new_grids[lev]);
             const auto old_num_setdm = num_setdm;
             MakeNewLevelFromCoarse(lev, time, new_grids[lev], new_dmap);
             SetBoxArray(lev, new_grids[lev]);
@@ -115,6 +170,8 @@ AmrCore::regrid (int lbase, Real time, bool)
     }
 
     finest_level = new_finest;
+
+    UpdateBoxCosts();
 }
 
 
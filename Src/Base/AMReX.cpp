@@ -638,6 +638,14 @@ amrex::Finalize (amrex::AMReX* pamrex)
 			       << "max used in a rank: " << global_max << " MB.\n";
 	    }
 	}
+
+        Long mp_hits, mp_misses;
+        amrex_mempool_get_cache_stats(mp_hits, mp_misses);
+        ParallelDescriptor::ReduceLongSum({mp_hits, mp_misses});
+        if (mp_hits + mp_misses > 0) {
+            amrex::Print() << "MemPool cache: hits: " << mp_hits
+                           << ", misses: " << mp_misses << ".\n";
+        }
     }
 #endif
 
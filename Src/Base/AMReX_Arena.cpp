@@ -4,12 +4,16 @@
 #include <AMReX_CArena.H>
 #include <AMReX_DArena.H>
 #include <AMReX_EArena.H>
+#include <AMReX_LArena.H>
 
 #include <AMReX.H>
 #include <AMReX_Print.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Gpu.H>
+#include <AMReX_OpenMP.H>
+
+#include <cstdint>
 
 #ifdef _WIN32
 ///#include <memoryapi.h>
@@ -23,6 +27,10 @@
 #define AMREX_MUNLOCK(x,y) munlock(x,y)
 #endif
 
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+#define AMREX_USE_HUGE_PAGES 1
+#endif
+
 namespace amrex {
 
 namespace {
@@ -33,19 +41,107 @@ namespace {
     Arena* the_managed_arena = nullptr;
     Arena* the_pinned_arena = nullptr;
     Arena* the_cpu_arena = nullptr;
+    Arena* the_step_arena = nullptr;
 
     bool use_buddy_allocator = false;
     Long buddy_allocator_size = 0L;
     Long the_arena_init_size = 0L;
+    Long the_step_arena_size = 0L;
+    std::string the_arena_huge_pages = "none";
+    bool the_arena_numa_first_touch = false;
 #ifdef AMREX_USE_HIP
     bool the_arena_is_managed = false; // xxxxx HIP FIX HERE
 #else
     bool the_arena_is_managed = true;
 #endif
     bool abort_on_out_of_gpu_memory = false;
+
+#ifdef AMREX_USE_HUGE_PAGES
+    constexpr std::size_t huge_page_size = 2*1024*1024;
+#endif
+
+    //
+    // Pages are placed on the NUMA node of the thread that first touches
+    // them.  Write one byte of each page that lies entirely in the new
+    // memory, with the pages shared out like the iterations of a loop with
+    // a static schedule.  The partial pages at the ends may belong to
+    // other allocations, so they are left alone.
+    //
+    void first_touch (void* p, std::size_t nbytes)
+    {
+#ifdef _OPENMP
+        if (OpenMP::in_parallel()) return;
+        constexpr std::uintptr_t page_size = 4096;
+        const std::uintptr_t b = (reinterpret_cast<std::uintptr_t>(p) + page_size-1)
+            & ~(page_size-1);
+        const std::uintptr_t e = (reinterpret_cast<std::uintptr_t>(p) + nbytes)
+            & ~(page_size-1);
+        if (e <= b) return;
+        const Long npages = static_cast<Long>((e-b)/page_size);
+        char* q = reinterpret_cast<char*>(b);
+#pragma omp parallel for schedule(static)
+        for (Long i = 0; i < npages; ++i) {
+            q[i*page_size] = 0;
+        }
+#else
+        amrex::ignore_unused(p,nbytes);
+#endif
+    }
+
+    void* allocate_host (std::size_t nbytes, ArenaInfo const& info)
+    {
+        void* p = nullptr;
+#ifdef AMREX_USE_HUGE_PAGES
+        if (info.use_hugetlbfs)
+        {
+            // mmap/munmap of hugetlbfs mappings need whole huge pages.
+            const std::size_t sz = amrex::aligned_size(huge_page_size, nbytes);
+            p = mmap(nullptr, sz, PROT_READ|PROT_WRITE,
+                     MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+            if (p == MAP_FAILED) {
+                // Not enough huge pages reserved.  Fall back to THP.
+                p = mmap(nullptr, sz, PROT_READ|PROT_WRITE,
+                         MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+                if (p == MAP_FAILED) {
+                    p = nullptr;
+                } else {
+                    madvise(p, sz, MADV_HUGEPAGE);
+                }
+            }
+        }
+        else if (info.use_huge_pages && nbytes >= huge_page_size)
+        {
+            if (posix_memalign(&p, huge_page_size, nbytes) != 0) {
+                p = nullptr;
+            } else {
+                madvise(p, nbytes, MADV_HUGEPAGE);
+            }
+        }
+        else
+#endif
+        {
+            p = std::malloc(nbytes);
+        }
+        if (p && info.numa_first_touch) first_touch(p, nbytes);
+        if (p && info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+        return p;
+    }
+
+    void deallocate_host (void* p, std::size_t nbytes, ArenaInfo const& info)
+    {
+        if (p && info.device_use_hostalloc) AMREX_MUNLOCK(p, nbytes);
+#ifdef AMREX_USE_HUGE_PAGES
+        if (info.use_hugetlbfs) {
+            if (p) munmap(p, amrex::aligned_size(huge_page_size, nbytes));
+            return;
+        }
+#endif
+        std::free(p);
+    }
 }
 
 const std::size_t Arena::align_size;
+Arena::AllocHook Arena::alloc_hook = nullptr;
 
 Arena::~Arena () {}
 
@@ -62,8 +158,7 @@ Arena::allocate_system (std::size_t nbytes)
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
-        p = std::malloc(nbytes);
-        if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+        p = allocate_host(nbytes, arena_info);
     }
     else if (arena_info.device_use_hostalloc)
     {
@@ -107,8 +202,7 @@ Arena::allocate_system (std::size_t nbytes)
         }
     }
 #else
-    p = std::malloc(nbytes);
-    if (p && arena_info.device_use_hostalloc) AMREX_MLOCK(p, nbytes);
+    p = allocate_host(nbytes, arena_info);
 #endif
     if (p == nullptr) amrex::Abort("Sorry, malloc failed");
     return p;
@@ -120,8 +214,7 @@ Arena::deallocate_system (void* p, std::size_t nbytes)
 #ifdef AMREX_USE_GPU
     if (arena_info.use_cpu_memory)
     {
-        if (p && arena_info.device_use_hostalloc) AMREX_MUNLOCK(p, nbytes);
-        std::free(p);
+        deallocate_host(p, nbytes, arena_info);
     }
     else if (arena_info.device_use_hostalloc)
     {
@@ -138,8 +231,7 @@ Arena::deallocate_system (void* p, std::size_t nbytes)
              sycl::free(p,Gpu::Device::syclContext()));
     }
 #else
-    if (p && arena_info.device_use_hostalloc) AMREX_MUNLOCK(p, nbytes);
-    std::free(p);
+    deallocate_host(p, nbytes, arena_info);
 #endif
 }
 
@@ -154,14 +246,30 @@ Arena::Initialize ()
     BL_ASSERT(the_managed_arena == nullptr);
     BL_ASSERT(the_pinned_arena == nullptr);
     BL_ASSERT(the_cpu_arena == nullptr);
+    BL_ASSERT(the_step_arena == nullptr);
 
     ParmParse pp("amrex");
     pp.query("use_buddy_allocator", use_buddy_allocator);
     pp.query("buddy_allocator_size", buddy_allocator_size);
     pp.query("the_arena_init_size", the_arena_init_size);
     pp.query("the_arena_is_managed", the_arena_is_managed);
+    pp.query("the_step_arena_size", the_step_arena_size);
+    pp.query("the_arena_huge_pages", the_arena_huge_pages);
+    pp.query("the_arena_numa_first_touch", the_arena_numa_first_touch);
     pp.query("abort_on_out_of_gpu_memory", abort_on_out_of_gpu_memory);
 
+    {
+        std::string fit_policy = "first_fit";
+        pp.query("carena_fit_policy", fit_policy);
+        if (fit_policy == "first_fit") {
+            CArena::defaultFitPolicy(CArena::FitPolicy::FirstFit);
+        } else if (fit_policy == "segregated_fit") {
+            CArena::defaultFitPolicy(CArena::FitPolicy::SegregatedFit);
+        } else {
+            amrex::Abort("amrex.carena_fit_policy: unknown policy " + fit_policy);
+        }
+    }
+
 #ifdef AMREX_USE_GPU
     if (use_buddy_allocator)
     {
@@ -203,7 +311,25 @@ Arena::Initialize ()
         the_arena->free(p);
 #endif
 #else
-        the_arena = new BArena;
+        ArenaInfo info;
+        if (the_arena_huge_pages == "thp") {
+            info.SetHugePages(false);
+        } else if (the_arena_huge_pages == "hugetlbfs") {
+            info.SetHugePages(true);
+        } else if (the_arena_huge_pages != "none") {
+            amrex::Abort("amrex.the_arena_huge_pages: unknown value " + the_arena_huge_pages);
+        }
+        if (the_arena_numa_first_touch) {
+            info.SetNumaFirstTouch();
+        }
+        if (info.use_huge_pages || info.numa_first_touch) {
+            // Huge pages pay off for large hunks that are reused.  The
+            // first touch is done in allocate_system, which BArena does
+            // not use.
+            the_arena = new CArena(0, info);
+        } else {
+            the_arena = new BArena(info);
+        }
 #endif
     }
 
@@ -235,6 +361,12 @@ Arena::Initialize ()
     the_pinned_arena->free(p);
 
     the_cpu_arena = new BArena;
+
+    // The step arena uses the same kind of memory as The_Arena().  With
+    // the default size of zero, all its requests go to The_Arena().
+    std::size_t step_arena_size = (the_step_arena_size > 0)
+        ? static_cast<std::size_t>(the_step_arena_size) : 0;
+    the_step_arena = new LArena(step_arena_size, the_arena, the_arena->arenaInfo());
 }
 
 void
@@ -291,6 +423,12 @@ Arena::PrintUsage ()
             p->PrintUsage("The  Pinned Arena");
         }
     }
+    if (The_Step_Arena()) {
+        LArena* p = dynamic_cast<LArena*>(The_Step_Arena());
+        if (p && p->capacity() > 0) {
+            p->PrintUsage("The    Step Arena");
+        }
+    }
 }
     
 void
@@ -305,6 +443,9 @@ Arena::Finalize ()
     }
     
     initialized = false;
+
+    delete the_step_arena;
+    the_step_arena = nullptr;
     
     delete the_arena;
     the_arena = nullptr;
@@ -357,4 +498,11 @@ The_Cpu_Arena ()
     return the_cpu_arena;
 }
 
+Arena*
+The_Step_Arena ()
+{
+    BL_ASSERT(the_step_arena != nullptr);
+    return the_step_arena;
+}
+
 }
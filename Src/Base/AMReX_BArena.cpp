@@ -3,6 +3,7 @@
 void*
 amrex::BArena::alloc (std::size_t sz_)
 {
+    notify_alloc(sz_);
     return std::malloc(sz_);
 }
 
@@ -5,6 +5,7 @@
 #include <AMReX_Utility.H>
 #include <AMReX_MFIter.H>
 #include <AMReX_BaseFab.H>
+#include <AMReX_ParmParse.H>
 
 #ifdef AMREX_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -25,6 +26,7 @@ Long BARef::total_hash_bytes_hwm = 0L;
 
 bool    BARef::initialized = false;
 bool BoxArray::initialized = false;
+bool BoxArray::use_bvh     = false;
 
 namespace {
     const int bl_ignore_max = 100000;
@@ -85,6 +87,7 @@ BARef::~BARef ()
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
+    updateMemoryUsage_bvh(-1);
 #endif	    
 }
 
@@ -176,10 +179,13 @@ BARef::resize (Long n) {
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(-1);
     updateMemoryUsage_hash(-1);
+    updateMemoryUsage_bvh(-1);
 #endif
     m_abox.resize(n);
     hash.clear();
     has_hashmap = false;
+    bvh.clear();
+    has_bvh = false;
 #ifdef AMREX_MEM_PROFILING
     updateMemoryUsage_box(1);
 #endif
@@ -220,6 +226,20 @@ BARef::updateMemoryUsage_hash (int s)
 	}
     }
 }
+
+void
+BARef::updateMemoryUsage_bvh (int s)
+{
+    if (!bvh.empty()) {
+	Long b = bvh.bytes();
+	if (s > 0) {
+	    total_hash_bytes += b;
+	    total_hash_bytes_hwm = std::max(total_hash_bytes_hwm, total_hash_bytes);
+	} else {
+	    total_hash_bytes -= b;
+	}
+    }
+}
 #endif
 
 void
@@ -258,6 +278,12 @@ BoxArray::Initialize ()
     if (!initialized) {
 	initialized = true;
 	BARef::Initialize();
+
+        ParmParse pp("boxarray");
+        pp.query("use_bvh", use_bvh);
+
+        ParmParse ppbl("boxlist");
+        ppbl.query("sweep_threshold", BoxList::sweep_threshold);
     }
 
     amrex::ExecOnFinalize(BoxArray::Finalize);
@@ -1177,6 +1203,57 @@ BoxArray::intersections (const Box&                         bx,
                          std::vector< std::pair<int,Box> >& isects,
 			 bool                               first_only,
 			 const IntVect&                     ng) const
+{
+    if (use_bvh) {
+        intersections_bvh(bx, isects, first_only, ng);
+    } else {
+        intersections_hash(bx, isects, first_only, ng);
+    }
+}
+
+std::pair<IntVect,IntVect>
+BoxArray::bvhQueryRange (const Box& bx, const IntVect& ng) const
+{
+    // The boxes in m_abox are cell-centered and not coarsened.  Be
+    // generous, and let the callers check the exact intersections.
+    Box gbx = amrex::grow(bx,ng);
+    const IntVect& cr = crseRatio();
+    IntVect lo = (gbx.smallEnd() - getDoiHi()) * cr - 1;
+    IntVect hi = (gbx.bigEnd() + getDoiLo() + 1) * cr;
+    return std::make_pair(lo, hi);
+}
+
+void
+BoxArray::intersections_bvh (const Box&                         bx,
+                             std::vector< std::pair<int,Box> >& isects,
+                             bool                               first_only,
+                             const IntVect&                     ng) const
+{
+    BoxBVH const& bvh = getBVH();
+
+    isects.resize(0);
+
+    if (bvh.empty()) return;
+
+    BL_ASSERT(bx.ixType() == ixType());
+
+    const auto& range = bvhQueryRange(bx, ng);
+    bvh.query(range.first, range.second, [&] (int index) -> bool
+    {
+        const Box& isect = bx & amrex::grow((*this)[index],ng);
+        if (isect.ok()) {
+            isects.push_back(std::pair<int,Box>(index,isect));
+            return first_only;
+        }
+        return false;
+    });
+}
+
+void
+BoxArray::intersections_hash (const Box&                         bx,
+                              std::vector< std::pair<int,Box> >& isects,
+                              bool                               first_only,
+                              const IntVect&                     ng) const
 {
   // This is called too many times BL_PROFILE("BoxArray::intersections()");
 
@@ -1277,73 +1354,89 @@ BoxArray::complementIn (BoxList& bl, const Box& bx) const
 
     if (empty()) return;
 
-    BARef::HashType& BoxHashMap = getHashMap();
-
     BL_ASSERT(bx.ixType() == ixType());
 
-    Box gbx = bx;
+    Vector<Box> intersect_boxes;
 
-    IntVect glo = gbx.smallEnd();
-    IntVect ghi = gbx.bigEnd();
-    const IntVect& doilo = getDoiLo();
-    const IntVect& doihi = getDoiHi();
+    if (use_bvh)
+    {
+        const auto& range = bvhQueryRange(bx, IntVect::TheZeroVector());
+        getBVH().query(range.first, range.second, [&] (int index) -> bool
+        {
+            const Box& ibox = (*this)[index];
+            if (bx.intersects(ibox)) {
+                intersect_boxes.push_back(ibox);
+            }
+            return false;
+        });
+    }
+    else
+    {
+        BARef::HashType& BoxHashMap = getHashMap();
 
-    gbx.setSmall(glo - doihi).setBig(ghi + doilo);
-    gbx.refine(crseRatio()).coarsen(m_ref->crsn);
+        Box gbx = bx;
 
-    const IntVect& sm = amrex::max(gbx.smallEnd()-1, m_ref->bbox.smallEnd());
-    const IntVect& bg = amrex::min(gbx.bigEnd(),     m_ref->bbox.bigEnd());
+        IntVect glo = gbx.smallEnd();
+        IntVect ghi = gbx.bigEnd();
+        const IntVect& doilo = getDoiLo();
+        const IntVect& doihi = getDoiHi();
 
-    Box cbx(sm,bg);
-    cbx.normalize();
+        gbx.setSmall(glo - doihi).setBig(ghi + doilo);
+        gbx.refine(crseRatio()).coarsen(m_ref->crsn);
 
-    if (!cbx.intersects(m_ref->bbox)) return;
+        const IntVect& sm = amrex::max(gbx.smallEnd()-1, m_ref->bbox.smallEnd());
+        const IntVect& bg = amrex::min(gbx.bigEnd(),     m_ref->bbox.bigEnd());
 
-    auto TheEnd = BoxHashMap.cend();
+        Box cbx(sm,bg);
+        cbx.normalize();
 
-    Vector<Box> intersect_boxes;
-    auto& abox = m_ref->m_abox;
-    if (m_bat.is_null()) {
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = abox[index];
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+        if (!cbx.intersects(m_ref->bbox)) return;
+
+        auto TheEnd = BoxHashMap.cend();
+
+        auto& abox = m_ref->m_abox;
+        if (m_bat.is_null()) {
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = abox[index];
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
-    } else if (m_bat.is_simple()) {
-        IndexType t = ixType();
-        IntVect cr = crseRatio();
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = amrex::convert(amrex::coarsen(abox[index],cr),t);
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+            });
+        } else if (m_bat.is_simple()) {
+            IndexType t = ixType();
+            IntVect cr = crseRatio();
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = amrex::convert(amrex::coarsen(abox[index],cr),t);
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
-    } else {
-        AMREX_LOOP_3D(cbx, i, j, k,
-        {
-            auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
-            if (it != TheEnd) {
-                for (const int index : it->second) {
-                    const Box& ibox = m_bat.m_op.m_bndryReg(abox[index]);
-                    if (bx.intersects(ibox)) {
-                        intersect_boxes.push_back(ibox);
+            });
+        } else {
+            AMREX_LOOP_3D(cbx, i, j, k,
+            {
+                auto it = BoxHashMap.find(IntVect(AMREX_D_DECL(i,j,k)));
+                if (it != TheEnd) {
+                    for (const int index : it->second) {
+                        const Box& ibox = m_bat.m_op.m_bndryReg(abox[index]);
+                        if (bx.intersects(ibox)) {
+                            intersect_boxes.push_back(ibox);
+                        }
                     }
                 }
-            }
-        });
+            });
+        }
     }
 
     BoxList newbl(bl.ixType());
@@ -1370,6 +1463,14 @@ BoxArray::clear_hash_bin () const
         m_ref->hash.clear();
         m_ref->has_hashmap = false;
     }
+    if (!m_ref->bvh.empty())
+    {
+#ifdef AMREX_MEM_PROFILING
+	m_ref->updateMemoryUsage_bvh(-1);
+#endif
+        m_ref->bvh.clear();
+        m_ref->has_bvh = false;
+    }
 }
 
 //
@@ -1408,7 +1509,8 @@ BoxArray::removeOverlap (bool simplify)
     {
         if (m_ref->m_abox[i].ok())
         {
-            intersections(m_ref->m_abox[i],isects);
+            // The hash is updated with the new boxes below.
+            intersections_hash(m_ref->m_abox[i],isects,false,IntVect::TheZeroVector());
 
             for (int j = 0, N = isects.size(); j < N; j++)
             {
@@ -1536,6 +1638,36 @@ BoxArray::getHashMap () const
     return BoxHashMap;
 }
 
+BoxBVH const&
+BoxArray::getBVH () const
+{
+    BoxBVH& bvh = m_ref->bvh;
+
+    if (m_ref->HasBVH()) return bvh;
+
+#ifdef _OPENMP
+#pragma omp critical(intersections_lock)
+#endif
+    {
+        if (bvh.empty() && size() > 0)
+        {
+            bvh.build(m_ref->m_abox);
+
+#ifdef AMREX_MEM_PROFILING
+	    m_ref->updateMemoryUsage_bvh(1);
+#endif
+
+#ifdef _OPENMP
+#pragma omp flush
+#pragma omp atomic write
+#endif
+            m_ref->has_bvh = true;
+        }
+    }
+
+    return bvh;
+}
+
 void
 BoxArray::uniqify ()
 {
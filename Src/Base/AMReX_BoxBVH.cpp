@@ -0,0 +1,150 @@
+#include <AMReX_BoxBVH.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_Utility.H>
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace amrex {
+
+namespace {
+
+    constexpr int morton_bits = (AMREX_SPACEDIM == 1) ? 63 : 63/AMREX_SPACEDIM;
+
+    std::uint64_t morton_code (IntVect const& c, IntVect const& cmin, int shift) noexcept
+    {
+        std::uint64_t x[AMREX_SPACEDIM];
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            x[d] = static_cast<std::uint64_t>(static_cast<Long>(c[d]) - cmin[d]) >> shift;
+        }
+        std::uint64_t code = 0;
+        for (int b = 0; b < morton_bits; ++b) {
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                code |= ((x[d] >> b) & 1ULL) << (b*AMREX_SPACEDIM + d);
+            }
+        }
+        return code;
+    }
+}
+
+void
+BoxBVH::build (Vector<Box> const& boxes)
+{
+    clear();
+
+    const int N = boxes.size();
+    if (N == 0) return;
+
+    //
+    // Box centers and their bounds
+    //
+    Vector<IntVect> center(N);
+    IntVect cmin(std::numeric_limits<int>::max());
+    IntVect cmax(std::numeric_limits<int>::lowest());
+#ifdef _OPENMP
+#pragma omp parallel if (N >= 16384)
+#endif
+    {
+        IntVect tmin(std::numeric_limits<int>::max());
+        IntVect tmax(std::numeric_limits<int>::lowest());
+#ifdef _OPENMP
+#pragma omp for
+#endif
+        for (int i = 0; i < N; ++i) {
+            center[i] = (boxes[i].smallEnd() + boxes[i].bigEnd()) / 2;
+            tmin.min(center[i]);
+            tmax.max(center[i]);
+        }
+#ifdef _OPENMP
+#pragma omp critical (amrex_boxbvh)
+#endif
+        {
+            cmin.min(tmin);
+            cmax.max(tmax);
+        }
+    }
+
+    int shift = 0;
+    Long range = 0;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        range = std::max(range, static_cast<Long>(cmax[d]) - cmin[d]);
+    }
+    while ((range >> shift) >= (Long(1) << morton_bits)) ++shift;
+
+    Vector<std::pair<std::uint64_t,int> > codes(N);
+#ifdef _OPENMP
+#pragma omp parallel for if (N >= 16384)
+#endif
+    for (int i = 0; i < N; ++i) {
+        codes[i] = std::make_pair(morton_code(center[i], cmin, shift), i);
+    }
+
+    amrex::ThreadedSort(codes);
+
+    m_index.resize(N);
+    for (int i = 0; i < N; ++i) {
+        m_index[i] = codes[i].second;
+    }
+
+    //
+    // The leaves, and then the levels above them.
+    //
+    int nnodes = (N + node_size - 1) / node_size;
+    m_nodes.emplace_back(nnodes);
+    {
+        Vector<Node>& leaves = m_nodes.back();
+#ifdef _OPENMP
+#pragma omp parallel for if (nnodes >= 2048)
+#endif
+        for (int n = 0; n < nnodes; ++n) {
+            const int end = std::min((n+1)*node_size, N);
+            Node nd{boxes[m_index[n*node_size]].smallEnd(), boxes[m_index[n*node_size]].bigEnd()};
+            for (int i = n*node_size+1; i < end; ++i) {
+                nd.lo.min(boxes[m_index[i]].smallEnd());
+                nd.hi.max(boxes[m_index[i]].bigEnd());
+            }
+            leaves[n] = nd;
+        }
+    }
+
+    while (nnodes > 1)
+    {
+        const int nchildren = nnodes;
+        nnodes = (nchildren + node_size - 1) / node_size;
+        m_nodes.emplace_back(nnodes);
+        Vector<Node> const& children = m_nodes[m_nodes.size()-2];
+        Vector<Node>& parents = m_nodes.back();
+#ifdef _OPENMP
+#pragma omp parallel for if (nnodes >= 2048)
+#endif
+        for (int n = 0; n < nnodes; ++n) {
+            const int end = std::min((n+1)*node_size, nchildren);
+            Node nd = children[n*node_size];
+            for (int c = n*node_size+1; c < end; ++c) {
+                nd.lo.min(children[c].lo);
+                nd.hi.max(children[c].hi);
+            }
+            parents[n] = nd;
+        }
+    }
+}
+
+void
+BoxBVH::clear () noexcept
+{
+    m_index.clear();
+    m_nodes.clear();
+}
+
+Long
+BoxBVH::bytes () const noexcept
+{
+    Long b = sizeof(*this) + amrex::bytesOf(m_index);
+    for (auto const& v : m_nodes) {
+        b += amrex::bytesOf(v);
+    }
+    return b;
+}
+
+}
@@ -0,0 +1,132 @@
+#include <AMReX_BoxCosts.H>
+#include <AMReX_MFIter.H>
+#include <AMReX_ParallelDescriptor.H>
+#ifdef AMREX_TINY_PROFILING
+#include <AMReX_TinyProfiler.H>
+#endif
+
+#include <algorithm>
+#include <numeric>
+
+namespace amrex {
+
+Vector<BoxCosts*> BoxCosts::m_active;
+
+BoxCosts::BoxCosts (const BoxArray& ba, const DistributionMapping& dm,
+                    const std::string& region)
+    : m_ba(ba),
+      m_dm(dm),
+      m_region(region),
+      m_measured(ba, dm)
+{
+    for (MFIter mfi(m_measured); mfi.isValid(); ++mfi) {
+        m_measured[mfi] = 0.;
+    }
+    m_active.push_back(this);
+}
+
+BoxCosts::~BoxCosts ()
+{
+    m_active.erase(std::find(m_active.begin(), m_active.end(), this));
+}
+
+void
+BoxCosts::add (const MFIter& mfi, Real t) noexcept
+{
+    Real& c = m_measured[mfi];
+#ifdef _OPENMP
+#pragma omp atomic
+#endif
+    c += t;
+}
+
+void
+BoxCosts::update (Real alpha)
+{
+    BL_PROFILE("BoxCosts::update()");
+
+    Vector<Real> cost(m_ba.size());
+    ParallelDescriptor::GatherLayoutDataToVector(m_measured, cost,
+                                                 ParallelContext::IOProcessorNumberSub());
+    ParallelDescriptor::Bcast(cost.data(), cost.size(), ParallelContext::IOProcessorNumberSub());
+
+    if (m_nupdates == 0 || m_smoothed.size() != cost.size()) {
+        m_smoothed = std::move(cost);
+    } else {
+        for (int i = 0, N = cost.size(); i < N; ++i) {
+            m_smoothed[i] = alpha*cost[i] + (1.-alpha)*m_smoothed[i];
+        }
+    }
+    ++m_nupdates;
+
+    for (MFIter mfi(m_measured); mfi.isValid(); ++mfi) {
+        m_measured[mfi] = 0.;
+    }
+}
+
+void
+BoxCosts::setSmoothed (Vector<Real> costs)
+{
+    AMREX_ALWAYS_ASSERT(static_cast<int>(costs.size()) == m_ba.size());
+    m_smoothed = std::move(costs);
+    m_nupdates = std::max(m_nupdates, 1);
+}
+
+Vector<Real>
+BoxCosts::costsOn (const BoxArray& ba) const
+{
+    BL_PROFILE("BoxCosts::costsOn()");
+
+    const int N = ba.size();
+    Vector<Real> r(N);
+
+    const Real total = std::accumulate(m_smoothed.begin(), m_smoothed.end(), Real(0.));
+    if (m_smoothed.empty() || total <= 0)
+    {
+        for (int i = 0; i < N; ++i) {
+            r[i] = static_cast<Real>(ba[i].numPts());
+        }
+        return r;
+    }
+
+    if (BoxArray::SameRefs(ba, m_ba)) {
+        return m_smoothed;
+    }
+
+    const Real average = total / static_cast<Real>(m_ba.numPts());
+    std::vector<std::pair<int,Box> > isects;
+    for (int i = 0; i < N; ++i)
+    {
+        const Box bx = amrex::convert(ba[i], m_ba.ixType());
+        m_ba.intersections(bx, isects);
+        Real c = 0;
+        Long ncovered = 0;
+        for (auto const& is : isects) {
+            const Long n = is.second.numPts();
+            c += m_smoothed[is.first] * n / static_cast<Real>(m_ba[is.first].numPts());
+            ncovered += n;
+        }
+        r[i] = c + average * std::max(bx.numPts()-ncovered, Long(0));
+    }
+    return r;
+}
+
+BoxCosts*
+BoxCosts::find (const FabArrayBase& fa) noexcept
+{
+    for (BoxCosts* bc : m_active)
+    {
+        // The loops over m_measured itself are not measured.
+        if (&fa == &bc->m_measured) continue;
+        if (BoxArray::SameRefs(bc->m_ba, fa.boxArray()) && bc->m_dm == fa.DistributionMap())
+        {
+#ifdef AMREX_TINY_PROFILING
+            if (!bc->m_region.empty() && !TinyProfiler::InRegion(bc->m_region)) continue;
+#endif
+            return bc;
+        }
+    }
+    return nullptr;
+}
+
+}
@@ -8,6 +8,7 @@
 #include <AMReX_BoxList.H>
 #include <AMReX_BLProfiler.H>
 #include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Utility.H>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -15,6 +16,8 @@
 
 namespace amrex {
 
+int BoxList::sweep_threshold = 256;
+
 namespace {
 
 static void chop_boxes (Box* bxv, const Box& bx, int nboxes)
@@ -59,6 +62,130 @@ static void chop_boxes_dir (Box* bxv, const Box& bx, int nboxes, int idir)
     }
 }
 
+//
+// Append the complement in b of the union of bxs, which must all be inside
+// b, to out.  We sweep along direction dir over the faces of the boxes.
+// The boxes covering a slab between consecutive faces are flattened onto
+// it, and the complement in the slab is found by sweeping along dir-1.
+// A box of the complement in a slab extends the box with the same cross
+// section in the previous slab, so every box is a maximal run in dir and
+// the result does not depend on how the union is cut into bxs.  bxs is
+// reordered.
+//
+void sweep_complement (const Box& b, Vector<Box>& bxs, int dir, Vector<Box>& out)
+{
+    if (bxs.empty()) {
+        out.push_back(b);
+        return;
+    }
+
+    std::sort(bxs.begin(), bxs.end(), [dir] (const Box& l, const Box& r)
+              { return l.smallEnd(dir) < r.smallEnd(dir); });
+
+    if (dir == 0)
+    {
+        int cur = b.smallEnd(0);
+        for (const auto& bx : bxs) {
+            if (bx.smallEnd(0) > cur) {
+                out.push_back(Box(b).setSmall(0,cur).setBig(0,bx.smallEnd(0)-1));
+            }
+            cur = std::max(cur, bx.bigEnd(0)+1);
+        }
+        if (cur <= b.bigEnd(0)) {
+            out.push_back(Box(b).setSmall(0,cur));
+        }
+        return;
+    }
+
+    Vector<int> faces;
+    faces.reserve(2*bxs.size()+2);
+    faces.push_back(b.smallEnd(dir));
+    faces.push_back(b.bigEnd(dir)+1);
+    for (const auto& bx : bxs) {
+        faces.push_back(bx.smallEnd(dir));
+        faces.push_back(bx.bigEnd(dir)+1);
+    }
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+
+    const int nboxes = bxs.size();
+    int next = 0;
+    Vector<int> active;
+    Vector<Box> slab_bxs, slab_out, open, next_open;
+
+    // Order by the cross section normal to dir.
+    auto section_less = [dir] (const Box& l, const Box& r) -> bool
+    {
+        for (int d = dir-1; d >= 0; --d) {
+            if (l.smallEnd(d) != r.smallEnd(d)) return l.smallEnd(d) < r.smallEnd(d);
+            if (l.bigEnd(d)   != r.bigEnd(d)  ) return l.bigEnd(d)   < r.bigEnd(d);
+        }
+        return false;
+    };
+
+    for (int f = 0, nf = faces.size(); f < nf-1; ++f)
+    {
+        const int zlo = faces[f];
+        const int zhi = faces[f+1]-1;
+
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [&] (int i) { return bxs[i].bigEnd(dir) < zlo; }),
+                     active.end());
+        while (next < nboxes && bxs[next].smallEnd(dir) <= zlo) {
+            active.push_back(next++);
+        }
+
+        slab_bxs.clear();
+        for (int i : active) {
+            slab_bxs.push_back(Box(bxs[i]).setSmall(dir,zlo).setBig(dir,zhi));
+        }
+        slab_out.clear();
+        sweep_complement(Box(b).setSmall(dir,zlo).setBig(dir,zhi), slab_bxs, dir-1, slab_out);
+        std::sort(slab_out.begin(), slab_out.end(), section_less);
+
+        //
+        // The open boxes end at zlo-1.  Those with the same cross section
+        // as a box in this slab are extended, and the others are done.
+        //
+        next_open.clear();
+        int i = 0, j = 0;
+        const int nopen = open.size(), nslab = slab_out.size();
+        while (i < nopen || j < nslab)
+        {
+            if (j == nslab || (i < nopen && section_less(open[i], slab_out[j]))) {
+                out.push_back(open[i++]);
+            } else if (i == nopen || section_less(slab_out[j], open[i])) {
+                next_open.push_back(slab_out[j++]);
+            } else {
+                next_open.push_back(open[i++].setBig(dir,zhi));
+                ++j;
+            }
+        }
+        std::swap(open, next_open);
+    }
+    out.insert(std::end(out), std::begin(open), std::end(open));
+}
+
+//
+// Append the complement of ba in block to bl.
+//
+void complement_in_block (Vector<Box>& bl, const Box& block, const BoxArray& ba, bool sweep,
+                          BoxList& bl_tmp, std::vector<std::pair<int,Box> >& isects,
+                          Vector<Box>& bxs)
+{
+    if (sweep) {
+        ba.intersections(block, isects);
+        bxs.clear();
+        for (const auto& is : isects) {
+            bxs.push_back(is.second);
+        }
+        sweep_complement(block, bxs, AMREX_SPACEDIM-1, bl);
+    } else {
+        ba.complementIn(bl_tmp, block);
+        bl.insert(std::end(bl), std::begin(bl_tmp), std::end(bl_tmp));
+    }
+}
+
 }
 
 void
@@ -343,7 +470,10 @@ BoxList::complementIn (const Box& b, const BoxArray& ba)
         *this = amrex::boxDiff(b, mbox);
         auto mytyp = ixType();
 
-        BoxList bl_mesh(mbox & b);
+        BoxList bl_mesh(mytyp);
+        if (mbox.intersects(b)) {
+            bl_mesh.push_back(mbox & b);
+        }
 
 #if (AMREX_SPACEDIM == 1)
         Real s_avgbox = npts_avgbox;
@@ -353,6 +483,7 @@ BoxList::complementIn (const Box& b, const BoxArray& ba)
         Real s_avgbox = std::cbrt(npts_avgbox);
 #endif
 
+        const bool sweep = sweep_threshold >= 0 && ba.size() >= sweep_threshold;
         const int block_size = 4 * std::max(1,static_cast<int>(std::ceil(s_avgbox/4.))*4);
         bl_mesh.maxSize(block_size);
         const int N = bl_mesh.size();
@@ -371,12 +502,13 @@ BoxList::complementIn (const Box& b, const BoxArray& ba)
 #pragma omp parallel
             {
                 BoxList bl_tmp(mytyp);
+                std::vector<std::pair<int,Box> > isects;
+                Vector<Box> bxs;
                 auto& vbox = bl_priv[omp_get_thread_num()].m_lbox;
 #pragma omp for
                 for (int i = 0; i < N; ++i)
                 {
-                    ba.complementIn(bl_tmp, bl_mesh.m_lbox[i]);
-                    vbox.insert(std::end(vbox), std::begin(bl_tmp), std::end(bl_tmp));
+                    complement_in_block(vbox, bl_mesh.m_lbox[i], ba, sweep, bl_tmp, isects, bxs);
                 }
             }
             for (auto& bl : bl_priv) {
@@ -389,10 +521,11 @@ BoxList::complementIn (const Box& b, const BoxArray& ba)
         else
         {
             BoxList bl_tmp(mytyp);
+            std::vector<std::pair<int,Box> > isects;
+            Vector<Box> bxs;
             for (int i = 0; i < N; ++i)
             {
-                ba.complementIn(bl_tmp, bl_mesh.m_lbox[i]);
-                m_lbox.insert(std::end(m_lbox), std::begin(bl_tmp), std::end(bl_tmp));
+                complement_in_block(m_lbox, bl_mesh.m_lbox[i], ba, sweep, bl_tmp, isects, bxs);
             }
         }
     }
@@ -432,7 +565,10 @@ BoxList::parallelComplementIn (const Box& b, BoxArray const& ba)
         *this = amrex::boxDiff(b, mbox);
         auto mytyp = ixType();
 
-        BoxList bl_mesh(mbox & b);
+        BoxList bl_mesh(mytyp);
+        if (mbox.intersects(b)) {
+            bl_mesh.push_back(mbox & b);
+        }
 
 #if (AMREX_SPACEDIM == 1)
         Real s_avgbox = npts_avgbox;
@@ -442,6 +578,7 @@ BoxList::parallelComplementIn (const Box& b, BoxArray const& ba)
         Real s_avgbox = std::cbrt(npts_avgbox);
 #endif
 
+        const bool sweep = sweep_threshold >= 0 && ba.size() >= sweep_threshold;
         const int block_size = 4 * std::max(1,static_cast<int>(std::ceil(s_avgbox/4.))*4);
         bl_mesh.maxSize(block_size);
         const int N = bl_mesh.size();
@@ -470,14 +607,15 @@ BoxList::parallelComplementIn (const Box& b, BoxArray const& ba)
 #pragma omp parallel reduction(+:ntot)
             {
                 BoxList bl_tmp(mytyp);
+                std::vector<std::pair<int,Box> > isects;
+                Vector<Box> bxs;
                 auto& vbox = bl_priv[omp_get_thread_num()].m_lbox;
 #pragma omp for
                 for (int i = ilo; i <= ihi; ++i)
                 {
-                    ba.complementIn(bl_tmp, bl_mesh.m_lbox[i]);
-                    vbox.insert(std::end(vbox), std::begin(bl_tmp), std::end(bl_tmp));
+                    complement_in_block(vbox, bl_mesh.m_lbox[i], ba, sweep, bl_tmp, isects, bxs);
                 }
-                ntot += bl_tmp.size();
+                ntot += vbox.size();
             }
             local_boxes.reserve(ntot);
             for (auto& bl : bl_priv) {
@@ -490,10 +628,11 @@ BoxList::parallelComplementIn (const Box& b, BoxArray const& ba)
         else
         {
             BoxList bl_tmp(mytyp);
+            std::vector<std::pair<int,Box> > isects;
+            Vector<Box> bxs;
             for (int i = ilo; i <= ihi; ++i)
             {
-                ba.complementIn(bl_tmp, bl_mesh.m_lbox[i]);
-                local_boxes.insert(std::end(local_boxes), std::begin(bl_tmp), std::end(bl_tmp));
+                complement_in_block(local_boxes, bl_mesh.m_lbox[i], ba, sweep, bl_tmp, isects, bxs);
             }
         }
 
@@ -658,6 +797,10 @@ boxDiff (BoxList& bl_diff, const Box& b1in, const Box& b2)
 int
 BoxList::simplify (bool best)
 {
+    if (sweep_threshold >= 0 && size() >= sweep_threshold) {
+        return simplify_sweep();
+    }
+
     std::sort(m_lbox.begin(), m_lbox.end(), [](const Box& l, const Box& r) {
             return l.smallEnd() < r.smallEnd(); });
 
@@ -750,6 +893,53 @@ BoxList::simplify_doit (int depth)
     return count;
 }
 
+int
+BoxList::simplify_sweep ()
+{
+    BL_PROFILE("BoxList::simplify_sweep()");
+
+    int count = 0;
+
+    for (int dir = 0; dir < AMREX_SPACEDIM; ++dir)
+    {
+        //
+        // Boxes with the same cross section normal to dir end up next to
+        // each other, in the order of their small ends in dir.
+        //
+        amrex::ThreadedSort(m_lbox, [dir] (const Box& l, const Box& r) -> bool
+        {
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                if (d == dir) continue;
+                if (l.smallEnd(d) != r.smallEnd(d)) return l.smallEnd(d) < r.smallEnd(d);
+                if (l.bigEnd(d)   != r.bigEnd(d)  ) return l.bigEnd(d)   < r.bigEnd(d);
+            }
+            return l.smallEnd(dir) < r.smallEnd(dir);
+        });
+
+        const int N = size();
+        int last = 0;
+        for (int i = 1; i < N; ++i)
+        {
+            Box& a = m_lbox[last];
+            const Box& b = m_lbox[i];
+            bool canjoin = b.smallEnd(dir) <= a.bigEnd(dir)+1;
+            for (int d = 0; d < AMREX_SPACEDIM && canjoin; ++d) {
+                canjoin = d == dir || (a.smallEnd(d) == b.smallEnd(d) &&
+                                       a.bigEnd(d)   == b.bigEnd(d));
+            }
+            if (canjoin) {
+                a.setBig(dir, std::max(a.bigEnd(dir), b.bigEnd(dir)));
+                ++count;
+            } else {
+                m_lbox[++last] = b;
+            }
+        }
+        if (N > 0) m_lbox.resize(last+1);
+    }
+
+    return count;
+}
+
 Box
 BoxList::minimalBox () const
 {
@@ -1,6 +1,7 @@
 
 #include <utility>
 #include <cstring>
+#include <algorithm>
 
 #include <AMReX_CArena.H>
 #include <AMReX_BLassert.H>
@@ -9,8 +10,29 @@
 
 namespace amrex {
 
-CArena::CArena (std::size_t hunk_size, ArenaInfo info)
+namespace {
+    // Size class of a chunk: floor(log2(nbytes)).
+    int seg_bin_of (std::size_t nbytes) noexcept
+    {
+        int b = 0;
+        while (nbytes >>= 1) { ++b; }
+        return b;
+    }
+}
+
+CArena::FitPolicy CArena::the_default_policy = CArena::FitPolicy::FirstFit;
+constexpr int CArena::m_num_bins;
+
+void
+CArena::defaultFitPolicy (FitPolicy policy) noexcept
 {
+    the_default_policy = (policy == FitPolicy::Default) ? FitPolicy::FirstFit : policy;
+}
+
+CArena::CArena (std::size_t hunk_size, ArenaInfo info, FitPolicy policy)
+    : m_policy(policy == FitPolicy::Default ? the_default_policy : policy)
+{
+    m_bins.fill(nullptr);
     arena_info = info;
     //
     // Force alignment of hunksize.
@@ -33,9 +55,15 @@ CArena::~CArena ()
 void*
 CArena::alloc (std::size_t nbytes)
 {
+    notify_alloc(nbytes);
+
     std::lock_guard<std::mutex> lock(carena_mutex);
 
     nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
+
+    if (m_policy == FitPolicy::SegregatedFit) {
+        return alloc_segregated(nbytes);
+    }
     //
     // Find node in freelist at lowest memory address that'll satisfy request.
     //
@@ -117,6 +145,11 @@ CArena::free (void* vp)
         // Allow calls with NULL as allowed by C++ delete.
         //
         return;
+
+    if (m_policy == FitPolicy::SegregatedFit) {
+        free_segregated(vp);
+        return;
+    }
     //
     // `vp' had better be in the busy list.
     //
@@ -191,6 +224,203 @@ CArena::free (void* vp)
     }
 }
 
+void*
+CArena::alloc_segregated (std::size_t nbytes)
+{
+    SegNode* node = seg_find(nbytes);
+
+    if (node == nullptr && m_seg_num_free > 1)
+    {
+        //
+        // Nothing fits.  Merge neighboring free chunks and try again
+        // before going to the system.
+        //
+        seg_coalesce();
+        node = seg_find(nbytes);
+    }
+
+    if (node == nullptr)
+    {
+        const std::size_t N = nbytes < m_hunk ? m_hunk : nbytes;
+
+        void* vp = allocate_system(N);
+
+        m_used += N;
+
+        m_alloc.push_back(std::make_pair(vp,N));
+
+        node = seg_new_node(vp, vp, N);
+    }
+    else
+    {
+        seg_unlink(node);
+    }
+
+    BL_ASSERT(node->size >= nbytes);
+
+    if (node->size > nbytes)
+    {
+        //
+        // Put the remainder back into its size class.
+        //
+        seg_push(seg_new_node(static_cast<char*>(node->block) + nbytes,
+                              node->owner, node->size - nbytes));
+        node->size = nbytes;
+    }
+
+    m_seg_busy.emplace(node->block, node);
+
+    m_actually_used += nbytes;
+
+    return node->block;
+}
+
+void
+CArena::free_segregated (void* vp)
+{
+    auto busy_it = m_seg_busy.find(vp);
+    if (busy_it == m_seg_busy.end()) {
+        amrex::Abort("CArena::free: unknown pointer");
+        return;
+    }
+
+    SegNode* node = busy_it->second;
+    m_seg_busy.erase(busy_it);
+
+    m_actually_used -= node->size;
+    //
+    // No coalescing here.  That is deferred until an allocation fails.
+    //
+    seg_push(node);
+}
+
+CArena::SegNode*
+CArena::seg_find (std::size_t nbytes) noexcept
+{
+    const int b = seg_bin_of(nbytes);
+    //
+    // Chunks in bin b have sizes in [2^b, 2^(b+1)).  They all fit if nbytes
+    // is a power of two.  Otherwise look at the first few of them before
+    // moving on to the larger classes, in which every chunk fits.
+    //
+    if (m_bins[b] != nullptr)
+    {
+        if ((nbytes & (nbytes-1)) == 0) {
+            return m_bins[b];
+        }
+        constexpr int max_search = 8;
+        int n = 0;
+        for (SegNode* p = m_bins[b]; p != nullptr && n < max_search; p = p->next, ++n) {
+            if (p->size >= nbytes) {
+                return p;
+            }
+        }
+    }
+
+    for (int i = b+1; i < m_num_bins; ++i) {
+        if (m_binmask & (std::uint64_t(1) << i)) {
+            return m_bins[i];
+        }
+    }
+
+    return nullptr;
+}
+
+CArena::SegNode*
+CArena::seg_new_node (void* block, void* owner, std::size_t size)
+{
+    SegNode* node;
+    if (m_spare_nodes.empty()) {
+        m_nodepool.emplace_back();
+        node = &(m_nodepool.back());
+    } else {
+        node = m_spare_nodes.back();
+        m_spare_nodes.pop_back();
+    }
+    *node = SegNode{};
+    node->block = block;
+    node->owner = owner;
+    node->size = size;
+    return node;
+}
+
+void
+CArena::seg_push (SegNode* node) noexcept
+{
+    const int b = seg_bin_of(node->size);
+    node->bin = b;
+    node->prev = nullptr;
+    node->next = m_bins[b];
+    if (node->next) {
+        node->next->prev = node;
+    }
+    m_bins[b] = node;
+    m_binmask |= (std::uint64_t(1) << b);
+    ++m_seg_num_free;
+}
+
+void
+CArena::seg_unlink (SegNode* node) noexcept
+{
+    const int b = node->bin;
+    BL_ASSERT(b >= 0 && b < m_num_bins);
+    if (node->prev) {
+        node->prev->next = node->next;
+    } else {
+        m_bins[b] = node->next;
+    }
+    if (node->next) {
+        node->next->prev = node->prev;
+    }
+    if (m_bins[b] == nullptr) {
+        m_binmask &= ~(std::uint64_t(1) << b);
+    }
+    node->prev = nullptr;
+    node->next = nullptr;
+    node->bin = -1;
+    --m_seg_num_free;
+}
+
+void
+CArena::seg_coalesce ()
+{
+    ++m_num_coalesce;
+
+    std::vector<SegNode*> nodes;
+    nodes.reserve(m_seg_num_free);
+    for (auto& head : m_bins) {
+        for (SegNode* p = head; p != nullptr; p = p->next) {
+            nodes.push_back(p);
+        }
+        head = nullptr;
+    }
+    m_binmask = 0;
+    m_seg_num_free = 0;
+
+    std::sort(nodes.begin(), nodes.end(),
+              [] (SegNode const* a, SegNode const* b) {
+                  return (a->owner < b->owner)
+                      || ((a->owner == b->owner) && (a->block < b->block));
+              });
+
+    SegNode* cur = nullptr;
+    for (SegNode* p : nodes)
+    {
+        if (cur && cur->owner == p->owner
+            && static_cast<char*>(cur->block) + cur->size == p->block)
+        {
+            cur->size += p->size;
+            m_spare_nodes.push_back(p);
+        }
+        else
+        {
+            if (cur) seg_push(cur);
+            cur = p;
+        }
+    }
+    if (cur) seg_push(cur);
+}
+
 std::size_t
 CArena::heap_space_used () const noexcept
 {
@@ -208,6 +438,9 @@ CArena::sizeOf (void* p) const noexcept
 {
     if (p == nullptr) {
         return 0;
+    } else if (m_policy == FitPolicy::SegregatedFit) {
+        auto it = m_seg_busy.find(p);
+        return (it == m_seg_busy.end()) ? 0 : it->second->size;
     } else {
         auto it = m_busylist.find(Node(p,0,0));
         if (it == m_busylist.end()) {
@@ -218,6 +451,31 @@ CArena::sizeOf (void* p) const noexcept
     }
 }
 
+CArena::FreeStats
+CArena::freeStats () const noexcept
+{
+    std::lock_guard<std::mutex> lock(carena_mutex);
+
+    FreeStats r;
+    if (m_policy == FitPolicy::SegregatedFit) {
+        for (SegNode const* head : m_bins) {
+            for (SegNode const* p = head; p != nullptr; p = p->next) {
+                ++r.num_free_blocks;
+                r.free_bytes += p->size;
+                r.largest_free_block = std::max(r.largest_free_block, p->size);
+            }
+        }
+        r.num_coalesce = m_num_coalesce;
+    } else {
+        for (auto const& node : m_freelist) {
+            ++r.num_free_blocks;
+            r.free_bytes += node.size();
+            r.largest_free_block = std::max(r.largest_free_block, node.size());
+        }
+    }
+    return r;
+}
+
 void
 CArena::PrintUsage (std::string const& name) const
 {
@@ -239,6 +497,33 @@ CArena::PrintUsage (std::string const& name) const
     amrex::Print() << "[" << name << "]" << " space allocated (MB): " << min_megabytes << "\n";
     amrex::Print() << "[" << name << "]" << " space used      (MB): " << actual_min_megabytes << "\n";
 #endif
+
+    if (m_policy == FitPolicy::SegregatedFit)
+    {
+        FreeStats const stats = freeStats();
+        Long min_nfree = stats.num_free_blocks;
+        Long max_nfree = min_nfree;
+        Long min_frag = static_cast<Long>(stats.fragmentation()*100.0);
+        Long max_frag = min_frag;
+        Long min_ncoal = stats.num_coalesce;
+        Long max_ncoal = min_ncoal;
+        ParallelReduce::Min<Long>({min_nfree, min_frag, min_ncoal},
+                                  IOProc, ParallelDescriptor::Communicator());
+        ParallelReduce::Max<Long>({max_nfree, max_frag, max_ncoal},
+                                  IOProc, ParallelDescriptor::Communicator());
+#ifdef AMREX_USE_MPI
+        amrex::Print() << "[" << name << "]" << " free chunks         spread across MPI: ["
+                       << min_nfree << " ... " << max_nfree << "]\n"
+                       << "[" << name << "]" << " fragmentation (%)   spread across MPI: ["
+                       << min_frag << " ... " << max_frag << "]\n"
+                       << "[" << name << "]" << " coalescing passes   spread across MPI: ["
+                       << min_ncoal << " ... " << max_ncoal << "]\n";
+#else
+        amrex::Print() << "[" << name << "]" << " free chunks      : " << min_nfree << "\n";
+        amrex::Print() << "[" << name << "]" << " fragmentation (%): " << min_frag << "\n";
+        amrex::Print() << "[" << name << "]" << " coalescing passes: " << min_ncoal << "\n";
+#endif
+    }
 }
 
 }
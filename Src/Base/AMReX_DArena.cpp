@@ -61,6 +61,8 @@ DArena::~DArena ()
 void*
 DArena::alloc (std::size_t nbytes)
 {
+    notify_alloc(nbytes);
+
     if (nbytes == 0) return nullptr; // behavior different from the standard
 
     // We need to allocate this many blocks
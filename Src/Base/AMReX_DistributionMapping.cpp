@@ -13,9 +13,13 @@
 #include <fstream>
 #include <sstream>
 #include <cstdlib>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <map>
 #include <vector>
 #include <queue>
+#include <set>
 #include <algorithm>
 #include <numeric>
 #include <string>
@@ -36,6 +40,8 @@ namespace amrex {
     int    sfc_threshold;
     Real   max_efficiency;
     int    node_size;
+    int    halo_width;
+    Real   node_tolerance;
 
 // We default to SFC.
 DistributionMapping::Strategy DistributionMapping::m_Strategy = DistributionMapping::SFC;
@@ -73,6 +79,13 @@ DistributionMapping::strategy (DistributionMapping::Strategy how)
     case RRSFC:
         m_BuildMap = &DistributionMapping::RRSFCProcessorMap;
         break;
+    case HILBERT:
+        // The SFC functions use the Hilbert curve with this strategy.
+        m_BuildMap = &DistributionMapping::SFCProcessorMap;
+        break;
+    case NODESFC:
+        m_BuildMap = &DistributionMapping::NodeSFCProcessorMap;
+        break;
     default:
         amrex::Error("Bad DistributionMapping::Strategy");
     }
@@ -90,6 +103,19 @@ DistributionMapping::SFC_Threshold ()
     return sfc_threshold;
 }
 
+int
+DistributionMapping::NodeOf (int rank) noexcept
+{
+    return (node_size > 0) ? rank/node_size : ParallelDescriptor::NodeOf(rank);
+}
+
+int
+DistributionMapping::NNodes () noexcept
+{
+    return (node_size > 0) ? (ParallelDescriptor::NProcs()+node_size-1)/node_size
+                           : ParallelDescriptor::NNodes();
+}
+
 bool
 DistributionMapping::operator== (const DistributionMapping& rhs) const noexcept
 {
@@ -113,6 +139,8 @@ DistributionMapping::Initialize ()
     sfc_threshold    = 0;
     max_efficiency   = 0.9;
     node_size        = 0;
+    halo_width       = 1;
+    node_tolerance   = 0.05;
     flag_verbose_mapper = 0;
 
     ParmParse pp("DistributionMapping");
@@ -122,6 +150,8 @@ DistributionMapping::Initialize ()
     pp.query("efficiency",          max_efficiency);
     pp.query("sfc_threshold",       sfc_threshold);
     pp.query("node_size",           node_size);
+    pp.query("halo_width",          halo_width);
+    pp.query("node_tolerance",      node_tolerance);
     pp.query("verbose_mapper",      flag_verbose_mapper);
 
     std::string theStrategy;
@@ -144,6 +174,14 @@ DistributionMapping::Initialize ()
         {
             strategy(RRSFC);
         }
+        else if (theStrategy == "HILBERT")
+        {
+            strategy(HILBERT);
+        }
+        else if (theStrategy == "NODESFC")
+        {
+            strategy(NODESFC);
+        }
         else
         {
             std::string msg("Unknown strategy: ");
@@ -697,6 +735,96 @@ top: ;
     }
 }
 
+//
+// Multi-constraint knapsack.  wgts[c][i] is the normalized cost c of box i.
+// The boxes are taken largest first, and each is put in the bin, among a
+// few of the least loaded ones, that ends up with the smallest maximum load
+// over the constraints.
+//
+static
+void
+knapsack (const Vector<Vector<Real> >&     wgts,
+          int                              nprocs,
+          std::vector< std::vector<int> >& result,
+          int                              nmax)
+{
+    BL_PROFILE("knapsack_multi()");
+
+    const int ncon = wgts.size();
+    const int N = wgts[0].size();
+
+    result.clear();
+    result.resize(nprocs);
+
+    std::vector<std::pair<Real,int> > order(N);
+    for (int i = 0; i < N; ++i) {
+        Real w = 0;
+        for (int c = 0; c < ncon; ++c) {
+            w = std::max(w, wgts[c][i]);
+        }
+        order[i] = std::make_pair(-w, i);
+    }
+    std::sort(order.begin(), order.end());
+
+    // Bins ordered by their maximum load, lightest first
+    using Bin = std::pair<Real,int>;
+    std::priority_queue<Bin, std::vector<Bin>, std::greater<Bin> > bins;
+    for (int p = 0; p < nprocs; ++p) {
+        bins.push(Bin(0.,p));
+    }
+
+    Vector<Real> load(static_cast<Long>(nprocs)*ncon, 0.);
+    const int ncandidates = std::min(nprocs, 2*ncon+2);
+    std::vector<Bin> candidates;
+
+    for (int k = 0; k < N; ++k)
+    {
+        const int i = order[k].second;
+
+        if (bins.empty()) {
+            result[k % nprocs].push_back(i);
+            continue;
+        }
+
+        candidates.clear();
+        for (int n = 0; n < ncandidates && !bins.empty(); ++n) {
+            candidates.push_back(bins.top());
+            bins.pop();
+        }
+
+        int best = 0;
+        Real best_max = std::numeric_limits<Real>::max();
+        Real best_sum = std::numeric_limits<Real>::max();
+        for (int n = 0, M = candidates.size(); n < M; ++n) {
+            const Real* lp = load.data() + static_cast<Long>(candidates[n].second)*ncon;
+            Real mx = 0, sm = 0;
+            for (int c = 0; c < ncon; ++c) {
+                mx = std::max(mx, lp[c] + wgts[c][i]);
+                sm += lp[c] + wgts[c][i];
+            }
+            if (mx < best_max || (mx == best_max && sm < best_sum)) {
+                best = n;
+                best_max = mx;
+                best_sum = sm;
+            }
+        }
+
+        const int p = candidates[best].second;
+        Real* lp = load.data() + static_cast<Long>(p)*ncon;
+        for (int c = 0; c < ncon; ++c) {
+            lp[c] += wgts[c][i];
+        }
+        result[p].push_back(i);
+        candidates[best].first = best_max;
+
+        for (int n = 0, M = candidates.size(); n < M; ++n) {
+            if (n != best || static_cast<int>(result[p].size()) < nmax) {
+                bins.push(candidates[n]);
+            }
+        }
+    }
+}
+
 void
 DistributionMapping::KnapSackDoIt (const std::vector<Long>& wgts,
                                    int                    /*  nprocs */,
@@ -877,6 +1005,85 @@ DistributionMapping::KnapSackProcessorMap (const BoxArray& boxes,
     }
 }
 
+//
+// This is Skilling's algorithm (AIP Conf. Proc. 707, 381, 2004), which
+// transforms the coordinates in place into the "transposed" index, whose
+// bits are then interleaved with x[0] the most significant.
+//
+std::uint64_t
+HilbertIndex (std::uint32_t x[AMREX_SPACEDIM], int nbits)
+{
+    const std::uint32_t M = 1u << (nbits-1);
+
+    // Inverse undo excess work
+    for (std::uint32_t Q = M; Q > 1; Q >>= 1) {
+        const std::uint32_t P = Q-1;
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            if (x[i] & Q) {
+                x[0] ^= P;
+            } else {
+                const std::uint32_t t = (x[0] ^ x[i]) & P;
+                x[0] ^= t;
+                x[i] ^= t;
+            }
+        }
+    }
+
+    // Gray encode
+    for (int i = 1; i < AMREX_SPACEDIM; ++i) {
+        x[i] ^= x[i-1];
+    }
+    std::uint32_t t = 0;
+    for (std::uint32_t Q = M; Q > 1; Q >>= 1) {
+        if (x[AMREX_SPACEDIM-1] & Q) t ^= Q-1;
+    }
+    for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+        x[i] ^= t;
+    }
+
+    std::uint64_t h = 0;
+    for (int b = nbits-1; b >= 0; --b) {
+        for (int i = 0; i < AMREX_SPACEDIM; ++i) {
+            h = (h << 1) | ((x[i] >> b) & 1u);
+        }
+    }
+    return h;
+}
+
+Vector<std::uint64_t>
+HilbertIndices (const Vector<IntVect>& pts)
+{
+    const int n = pts.size();
+    Vector<std::uint64_t> r(n);
+    if (n == 0) return r;
+
+    IntVect lo(std::numeric_limits<int>::max());
+    IntVect hi(std::numeric_limits<int>::lowest());
+    for (auto const& p : pts) {
+        lo.min(p);
+        hi.max(p);
+    }
+
+    constexpr int max_bits = (63/AMREX_SPACEDIM < 31) ? 63/AMREX_SPACEDIM : 31;
+    Long range = 1;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        range = std::max(range, static_cast<Long>(hi[d]) - lo[d] + 1);
+    }
+    int nbits = 1;
+    while (nbits < max_bits && (Long(1) << nbits) < range) ++nbits;
+    int shift = 0;
+    while (((range-1) >> shift) >= (Long(1) << nbits)) ++shift;
+
+    for (int i = 0; i < n; ++i) {
+        std::uint32_t x[AMREX_SPACEDIM];
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            x[d] = static_cast<std::uint32_t>((static_cast<Long>(pts[i][d]) - lo[d]) >> shift);
+        }
+        r[i] = HilbertIndex(x, nbits);
+    }
+    return r;
+}
+
 namespace
 {
     struct SFCToken
@@ -1033,6 +1240,65 @@ namespace {
 
         return token;
     }
+
+    //
+    // Tokens of the boxes sorted along a space filling curve.  The Hilbert
+    // curve goes through the centers of the boxes and covers their bounding
+    // box.  Its index is stored in m_morton so that the tokens can be
+    // printed the same way.
+    //
+    std::vector<SFCToken> sfc_order (const BoxArray& boxes, bool hilbert)
+    {
+        const int N = boxes.size();
+        std::vector<SFCToken> tokens;
+        tokens.reserve(N);
+
+        if (!hilbert)
+        {
+            for (int i = 0; i < N; ++i)
+            {
+                const Box& bx = boxes[i];
+                tokens.push_back(makeSFCToken(i, bx.smallEnd()));
+            }
+            //
+            // Put'm in Morton space filling curve order.
+            //
+            std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+        }
+        else
+        {
+            Vector<IntVect> center(N);
+            for (int i = 0; i < N; ++i) {
+                const Box& bx = boxes[i];
+                center[i] = (bx.smallEnd() + bx.bigEnd()) / 2;
+            }
+            const Vector<std::uint64_t> h = HilbertIndices(center);
+
+            std::vector<std::pair<std::uint64_t,int> > keys(N);
+            for (int i = 0; i < N; ++i) {
+                keys[i] = std::make_pair(h[i], i);
+            }
+            //
+            // Put'm in Hilbert space filling curve order.
+            //
+            std::sort(keys.begin(), keys.end());
+
+            for (auto const& k : keys) {
+                SFCToken token;
+                token.m_box = k.second;
+                token.m_morton[0] = static_cast<std::uint32_t>(k.first);
+#if (AMREX_SPACEDIM > 1)
+                token.m_morton[1] = static_cast<std::uint32_t>(k.first >> 32);
+#endif
+#if (AMREX_SPACEDIM > 2)
+                token.m_morton[2] = 0;
+#endif
+                tokens.push_back(token);
+            }
+        }
+
+        return tokens;
+    }
 }
 
 static
@@ -1119,6 +1385,82 @@ Distribute (const std::vector<SFCToken>&     tokens,
 #endif
 }
 
+//
+// Multi-constraint version.  wgts[c][i] is the normalized cost c of box i.
+// The curve is cut into at most nprocs pieces such that the largest load of
+// any constraint, relative to its average, is as small as possible.  For a
+// given bound, filling each piece as much as possible gives the fewest
+// pieces, so we search for the smallest bound that needs at most nprocs.
+//
+static
+void
+Distribute (const std::vector<SFCToken>&     tokens,
+            const Vector<Vector<Real> >&     wgts,
+            int                              nprocs,
+            std::vector< std::vector<int> >& v)
+{
+    BL_PROFILE("DistributionMapping::Distribute_multi()");
+
+    BL_ASSERT(static_cast<int>(v.size()) == nprocs);
+
+    const int ncon = wgts.size();
+    const int TSZ = tokens.size();
+
+    Vector<Real> load(ncon);
+
+    // Number of pieces needed for bound B, and the pieces if v is not null.
+    auto cut = [&] (Real B, std::vector< std::vector<int> >* vv) -> int
+    {
+        int npieces = 1;
+        int nboxes = 0;
+        std::fill(load.begin(), load.end(), Real(0.));
+        for (int K = 0; K < TSZ; ++K)
+        {
+            const int box = tokens[K].m_box;
+            bool fits = true;
+            for (int c = 0; c < ncon && fits; ++c) {
+                fits = (load[c] + wgts[c][box])*nprocs <= B;
+            }
+            if (!fits && nboxes > 0) {
+                ++npieces;
+                nboxes = 0;
+                std::fill(load.begin(), load.end(), Real(0.));
+            }
+            for (int c = 0; c < ncon; ++c) {
+                load[c] += wgts[c][box];
+            }
+            ++nboxes;
+            if (vv) {
+                (*vv)[std::min(npieces,nprocs)-1].push_back(box);
+            }
+        }
+        return npieces;
+    };
+
+    Real lo = 1., hi = nprocs;
+    for (int K = 0; K < TSZ; ++K) {
+        for (int c = 0; c < ncon; ++c) {
+            lo = std::max(lo, wgts[c][tokens[K].m_box]*nprocs);
+        }
+    }
+    hi = std::max(hi, lo);
+
+    if (cut(lo, nullptr) <= nprocs) {
+        hi = lo;
+    } else {
+        for (int iter = 0; iter < 50 && hi-lo > 1.e-6*lo; ++iter) {
+            const Real mid = 0.5*(lo+hi);
+            if (cut(mid, nullptr) <= nprocs) {
+                hi = mid;
+            } else {
+                lo = mid;
+            }
+        }
+    }
+
+    cut(hi, &v);
+}
+
 void
 DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
                                           const std::vector<Long>& wgts,
@@ -1156,17 +1498,7 @@ DistributionMapping::SFCProcessorMapDoIt (const BoxArray&          boxes,
     }
 
     const int N = boxes.size();
-    std::vector<SFCToken> tokens;
-    tokens.reserve(N);
-    for (int i = 0; i < N; ++i)
-    {
-        const Box& bx = boxes[i];
-        tokens.push_back(makeSFCToken(i, bx.smallEnd()));
-    }
-    //
-    // Put'm in Morton space filling curve order.
-    //
-    std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+    std::vector<SFCToken> tokens = sfc_order(boxes, m_Strategy == HILBERT);
     //
     // Split'm up as equitably as possible per team.
     //
@@ -1435,6 +1767,436 @@ DistributionMapping::RRSFCProcessorMap (const BoxArray&          boxes,
     RRSFCDoIt(boxes,nprocs);
 }
 
+namespace {
+
+    using HaloGraph = Vector<Vector<std::pair<int,Long> > >;
+
+    //
+    // g[i] holds the neighbors of box i and the number of ghost cells of
+    // width ng that box i and the neighbor fill from each other, sorted by
+    // neighbor.
+    //
+    HaloGraph halo_graph (const BoxArray& boxes, int ng)
+    {
+        BL_PROFILE("DistributionMapping::halo_graph()");
+
+        const int N = boxes.size();
+        HaloGraph g(N);
+        std::vector<std::pair<int,Box> > isects;
+        for (int i = 0; i < N; ++i)
+        {
+            boxes.intersections(amrex::grow(boxes[i],ng), isects);
+            for (auto const& is : isects)
+            {
+                if (is.first != i) {
+                    const Long n = is.second.numPts();
+                    g[i].push_back(std::make_pair(is.first,n));
+                    g[is.first].push_back(std::make_pair(i,n));
+                }
+            }
+        }
+        for (auto& nbrs : g)
+        {
+            std::sort(nbrs.begin(), nbrs.end());
+            int m = 0;
+            for (int k = 0, M = nbrs.size(); k < M; ++k) {
+                if (m > 0 && nbrs[m-1].first == nbrs[k].first) {
+                    nbrs[m-1].second += nbrs[k].second;
+                } else {
+                    nbrs[m++] = nbrs[k];
+                }
+            }
+            nbrs.resize(m);
+        }
+        return g;
+    }
+
+    // Number of ghost cells exchanged between the parts
+    Long cut_volume (const HaloGraph& g, const Vector<int>& part)
+    {
+        Long r = 0;
+        for (int i = 0, N = g.size(); i < N; ++i) {
+            for (auto const& nbr : g[i]) {
+                if (part[nbr.first] != part[i]) r += nbr.second;
+            }
+        }
+        return r/2;
+    }
+
+    //
+    // Move boxes on the boundaries of the parts to the part they exchange
+    // the most ghost cells with, as long as the load of no part goes above
+    // (1+tol) times its target or below (1-tol) times its target.  Parts
+    // that are already outside these bounds only get closer to them.
+    //
+    void refine_parts (const std::vector<SFCToken>& tokens, const std::vector<Long>& wgts,
+                       const HaloGraph& g, const Vector<Real>& target, Real tol,
+                       Vector<int>& part)
+    {
+        BL_PROFILE("DistributionMapping::refine_parts()");
+
+        const int nparts = target.size();
+        Vector<Real> load(nparts, 0.);
+        for (int i = 0, N = part.size(); i < N; ++i) {
+            load[part[i]] += wgts[i];
+        }
+
+        Vector<Long> conn(nparts, 0);
+        Vector<int> touched;
+
+        const int max_passes = 10;
+        for (int pass = 0; pass < max_passes; ++pass)
+        {
+            int nmoves = 0;
+            for (auto const& t : tokens)
+            {
+                const int i = t.m_box;
+                const int p = part[i];
+                const Real w = wgts[i];
+                if (load[p]-w < (1.-tol)*target[p]) continue;
+
+                touched.clear();
+                for (auto const& nbr : g[i]) {
+                    const int q = part[nbr.first];
+                    if (conn[q] == 0) touched.push_back(q);
+                    conn[q] += nbr.second;
+                }
+
+                int best = -1;
+                for (int q : touched) {
+                    if (q != p && conn[q] > conn[p] && load[q]+w <= (1.+tol)*target[q] &&
+                        (best < 0 || conn[q] > conn[best] || (conn[q] == conn[best] && q < best)))
+                    {
+                        best = q;
+                    }
+                }
+
+                if (best >= 0) {
+                    part[i] = best;
+                    load[p] -= w;
+                    load[best] += w;
+                    ++nmoves;
+                }
+
+                for (int q : touched) conn[q] = 0;
+            }
+            if (nmoves == 0) break;
+        }
+    }
+}
+
+void
+DistributionMapping::NodeSFCDoIt (const BoxArray&          boxes,
+                                  const std::vector<Long>& wgts,
+                                  bool                     sort,
+                                  Real*                    eff)
+{
+    BL_PROFILE("DistributionMapping::NodeSFCDoIt()");
+
+#if defined (BL_USE_TEAM)
+    amrex::Abort("Team support is not implemented yet in NODESFC");
+#endif
+
+    const int nprocs = ParallelContext::NProcsSub();
+    const int N = boxes.size();
+
+    //
+    // The processes of each node, numbered in the order of their lowest ranks.
+    //
+    Vector<Vector<int> > node_procs;
+    {
+        std::map<int,int> node_id;
+        for (int i = 0; i < nprocs; ++i) {
+            const int node = NodeOf(ParallelContext::local_to_global_rank(i));
+            auto r = node_id.insert(std::make_pair(node, static_cast<int>(node_procs.size())));
+            if (r.second) node_procs.emplace_back();
+            node_procs[r.first->second].push_back(i);
+        }
+    }
+    const int nnodes = node_procs.size();
+
+    Real totalvol = 0;
+    for (Long wt : wgts) {
+        totalvol += wt;
+    }
+
+    Vector<Real> target(nnodes);
+    for (int k = 0; k < nnodes; ++k) {
+        target[k] = totalvol * node_procs[k].size() / nprocs;
+    }
+
+    //
+    // Cut the curve into one piece per node.  A box goes to the piece that
+    // contains the middle of its weight.
+    //
+    auto cut_curve = [&] (const std::vector<SFCToken>& toks, Vector<int>& part)
+    {
+        part.resize(N);
+        int k = 0;
+        Real vol = 0, bound = target[0];
+        for (auto const& t : toks)
+        {
+            const Real w = wgts[t.m_box];
+            while (k < nnodes-1 && vol + 0.5*w > bound) {
+                bound += target[++k];
+            }
+            part[t.m_box] = k;
+            vol += w;
+        }
+    };
+
+    std::vector<SFCToken> tokens = sfc_order(boxes, true);
+    Vector<int> part;
+    cut_curve(tokens, part);
+
+    //
+    // Which curve gives fewer ghost cells between the nodes depends on how
+    // the boxes were made, so we try both the Hilbert and the Morton curves.
+    //
+    Long cut_sfc = 0, cut_refined = 0, total_halo = 0;
+    if (nnodes > 1)
+    {
+        HaloGraph g = halo_graph(boxes, halo_width);
+        refine_parts(tokens, wgts, g, target, node_tolerance, part);
+        cut_refined = cut_volume(g, part);
+
+        std::vector<SFCToken> mtokens = sfc_order(boxes, false);
+        Vector<int> mpart;
+        cut_curve(mtokens, mpart);
+        refine_parts(mtokens, wgts, g, target, node_tolerance, mpart);
+        const Long mcut = cut_volume(g, mpart);
+        if (mcut < cut_refined) {
+            std::swap(tokens, mtokens);
+            std::swap(part, mpart);
+            cut_refined = mcut;
+        }
+
+        if (verbose) {
+            Vector<int> sfc_part;
+            cut_curve(tokens, sfc_part);
+            cut_sfc = cut_volume(g, sfc_part);
+            Vector<int> all_apart(N);
+            std::iota(all_apart.begin(), all_apart.end(), 0);
+            total_halo = cut_volume(g, all_apart);
+        }
+    }
+
+    Vector<int> pos;   // position of each process in the least used ordering
+    if (sort) {
+        Vector<int> ord;
+        LeastUsedCPUs(nprocs, ord);
+        pos.resize(nprocs);
+        for (int i = 0; i < nprocs; ++i) {
+            pos[ord[i]] = i;
+        }
+    }
+
+    //
+    // Cut the piece of each node among its processes along the same curve,
+    // such that the heaviest process is as light as possible.
+    //
+    Vector<Vector<Real> > node_wgts(1, Vector<Real>(N, 0.));
+    Real sum_wgt = 0, max_wgt = 0;
+    for (int k = 0; k < nnodes; ++k)
+    {
+        std::vector<SFCToken> node_tokens;
+        Real nodevol = 0;
+        for (auto const& t : tokens) {
+            if (part[t.m_box] == k) {
+                node_tokens.push_back(t);
+                nodevol += wgts[t.m_box];
+            }
+        }
+
+        Vector<int>& procs = node_procs[k];
+        const int nworkers = procs.size();
+
+        for (auto const& t : node_tokens) {
+            node_wgts[0][t.m_box] = wgts[t.m_box] / nodevol;
+        }
+
+        std::vector< std::vector<int> > vec(nworkers);
+        Distribute(node_tokens, node_wgts, nworkers, vec);
+
+        std::vector<LIpair> LIpairV;
+        LIpairV.reserve(nworkers);
+        for (int w = 0; w < nworkers; ++w)
+        {
+            Long wgt = 0;
+            for (int ibox : vec[w]) {
+                wgt += wgts[ibox];
+            }
+            LIpairV.push_back(LIpair(wgt,w));
+            sum_wgt += wgt;
+            max_wgt = std::max(max_wgt, Real(wgt));
+        }
+
+        if (sort) {
+            Sort(LIpairV, true);
+            std::sort(procs.begin(), procs.end(),
+                      [&] (int a, int b) { return pos[a] < pos[b]; });
+        }
+
+        for (int w = 0; w < nworkers; ++w)
+        {
+            const int rank = ParallelContext::local_to_global_rank(procs[w]);
+            for (int ibox : vec[LIpairV[w].second]) {
+                m_ref->m_pmap[ibox] = rank;
+            }
+        }
+    }
+
+    const Real efficiency = (max_wgt > 0) ? sum_wgt/(nprocs*max_wgt) : Real(1.);
+    if (eff) *eff = efficiency;
+
+    if (verbose)
+    {
+        amrex::Print() << "NODESFC efficiency: " << efficiency << '\n';
+        if (nnodes > 1) {
+            amrex::Print() << "NODESFC ghost cells between " << nnodes << " nodes: "
+                           << cut_refined << " (" << cut_sfc << " before refinement, "
+                           << total_halo << " between all boxes)\n";
+        }
+    }
+}
+
+void
+DistributionMapping::NodeSFCProcessorMap (const BoxArray& boxes,
+                                          int             nprocs)
+{
+    BL_ASSERT(boxes.size() > 0);
+
+    m_ref->clear();
+    m_ref->m_pmap.resize(boxes.size());
+
+    if (boxes.size() < sfc_threshold*nprocs)
+    {
+        KnapSackProcessorMap(boxes,nprocs);
+    }
+    else
+    {
+        std::vector<Long> wgts;
+
+        wgts.reserve(boxes.size());
+
+        for (int i = 0, N = boxes.size(); i < N; ++i)
+        {
+            wgts.push_back(boxes[i].volume());
+        }
+
+        NodeSFCDoIt(boxes,wgts);
+    }
+}
+
+void
+DistributionMapping::AssignBuckets (const std::vector<std::vector<int> >& vec,
+                                    const Vector<Vector<Real> >&          wgts,
+                                    bool                                  sort,
+                                    Vector<Real>&                         efficiency)
+{
+    const int nprocs = vec.size();
+    const int ncon = wgts.size();
+
+    Vector<Real> sum_wgt(ncon, 0.), max_wgt(ncon, 0.);
+    std::vector<LIpair> LIpairV;
+    LIpairV.reserve(nprocs);
+
+    for (int i = 0; i < nprocs; ++i)
+    {
+        Real total = 0;
+        for (int c = 0; c < ncon; ++c) {
+            Real w = 0;
+            for (int ibox : vec[i]) {
+                w += wgts[c][ibox];
+            }
+            sum_wgt[c] += w;
+            max_wgt[c] = std::max(max_wgt[c], w);
+            total += w;
+        }
+        // The normalized costs add up to at most ncon.
+        LIpairV.push_back(LIpair(static_cast<Long>(total*1.e9),i));
+    }
+
+    efficiency.resize(ncon);
+    for (int c = 0; c < ncon; ++c) {
+        efficiency[c] = (max_wgt[c] > 0) ? sum_wgt[c]/(nprocs*max_wgt[c]) : Real(1.);
+    }
+
+    if (sort) Sort(LIpairV, true);
+
+    Vector<int> ord;
+    if (sort) {
+        LeastUsedCPUs(nprocs,ord);
+    } else {
+        ord.resize(nprocs);
+        std::iota(ord.begin(), ord.end(), 0);
+    }
+
+    for (int i = 0; i < nprocs; ++i)
+    {
+        const int rank = ParallelContext::local_to_global_rank(ord[i]);
+        for (int ibox : vec[LIpairV[i].second]) {
+            m_ref->m_pmap[ibox] = rank;
+        }
+    }
+}
+
+void
+DistributionMapping::KnapSackDoIt (const Vector<Vector<Real> >& wgts,
+                                   int                          nmax,
+                                   bool                         sort,
+                                   Vector<Real>&                efficiency)
+{
+    BL_PROFILE("DistributionMapping::KnapSackDoIt_multi()");
+
+#if defined (BL_USE_TEAM)
+    amrex::Abort("Team support is not implemented yet in multi-constraint KnapSack");
+#endif
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    std::vector< std::vector<int> > vec;
+    knapsack(wgts, nprocs, vec, nmax);
+
+    AssignBuckets(vec, wgts, sort, efficiency);
+
+    if (verbose)
+    {
+        amrex::Print() << "KNAPSACK efficiency:";
+        for (Real e : efficiency) amrex::Print() << " " << e;
+        amrex::Print() << '\n';
+    }
+}
+
+void
+DistributionMapping::SFCProcessorMapDoIt (const BoxArray&              boxes,
+                                          const Vector<Vector<Real> >& wgts,
+                                          bool                         sort,
+                                          Vector<Real>&                efficiency)
+{
+    BL_PROFILE("DistributionMapping::SFCProcessorMapDoIt_multi()");
+
+#if defined (BL_USE_TEAM)
+    amrex::Abort("Team support is not implemented yet in multi-constraint SFC");
+#endif
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    std::vector<SFCToken> tokens = sfc_order(boxes, m_Strategy == HILBERT);
+
+    std::vector< std::vector<int> > vec(nprocs);
+    Distribute(tokens, wgts, nprocs, vec);
+
+    AssignBuckets(vec, wgts, sort, efficiency);
+
+    if (verbose)
+    {
+        amrex::Print() << "SFC efficiency:";
+        for (Real e : efficiency) amrex::Print() << " " << e;
+        amrex::Print() << '\n';
+    }
+}
+
 DistributionMapping
 DistributionMapping::makeKnapSack (const Vector<Real>& rcost, int nmax)
 {
@@ -1482,6 +2244,61 @@ DistributionMapping::makeKnapSack (const Vector<Real>& rcost, Real& eff, int nma
     return r;
 }
 
+namespace {
+//
+// Scale each constraint so that it adds up to one.  A constraint without
+// any cost stays zero and is ignored, unless all of them are zero.
+//
+Vector<Vector<Real> >
+normalize_costs (const Vector<Vector<Real> >& rcosts)
+{
+    AMREX_ALWAYS_ASSERT(!rcosts.empty());
+    const int N = rcosts[0].size();
+    Vector<Vector<Real> > wgts(rcosts.size(), Vector<Real>(N, Real(0.)));
+    bool all_zero = true;
+    for (int c = 0, ncon = rcosts.size(); c < ncon; ++c) {
+        AMREX_ALWAYS_ASSERT(static_cast<int>(rcosts[c].size()) == N);
+        Real sum = std::accumulate(rcosts[c].begin(), rcosts[c].end(), Real(0.));
+        if (sum > 0) {
+            all_zero = false;
+            for (int i = 0; i < N; ++i) {
+                wgts[c][i] = rcosts[c][i] / sum;
+            }
+        }
+    }
+    if (all_zero) {
+        wgts[0].assign(N, Real(1.)/N);
+    }
+    return wgts;
+}
+}
+
+DistributionMapping
+DistributionMapping::makeKnapSack (const Vector<Vector<Real> >& rcosts, Vector<Real>& eff,
+                                   int nmax, bool sort)
+{
+    BL_PROFILE("makeKnapSack");
+
+    DistributionMapping r;
+
+    const int N = rcosts[0].size();
+    r.m_ref->m_pmap.resize(N);
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    if (N <= nprocs || nprocs < 2)
+    {
+        r.RoundRobinProcessorMap(N, nprocs);
+        eff.assign(rcosts.size(), Real(1.));
+    }
+    else
+    {
+        r.KnapSackDoIt(normalize_costs(rcosts), nmax, sort, eff);
+    }
+
+    return r;
+}
+
 DistributionMapping
 DistributionMapping::makeKnapSack (const LayoutData<Real>& rcost_local,
                                    Real& currentEfficiency, Real& proposedEfficiency,
@@ -1595,6 +2412,139 @@ DistributionMapping::ComputeDistributionMappingEfficiency (const DistributionMap
                                    rankToCost.end(), 0.0) / (nprocs*maxCost));
 }
 
+void
+DistributionMapping::ComputeDistributionMappingEfficiency (const DistributionMapping& dm,
+                                                           const Vector<Vector<Real> >& costs,
+                                                           Vector<Real>& efficiency)
+{
+    const int nprocs = ParallelDescriptor::NProcs();
+
+    efficiency.resize(costs.size());
+    Vector<Real> rankToCost(nprocs);
+
+    for (int c = 0, ncon = costs.size(); c < ncon; ++c)
+    {
+        std::fill(rankToCost.begin(), rankToCost.end(), Real(0.));
+        for (int i = 0; i < dm.size(); ++i) {
+            rankToCost[dm[i]] += costs[c][i];
+        }
+        const Real maxCost = *std::max_element(rankToCost.begin(), rankToCost.end());
+        const Real sumCost = std::accumulate(rankToCost.begin(), rankToCost.end(), Real(0.));
+        efficiency[c] = (maxCost > 0) ? sumCost / (nprocs*maxCost) : Real(1.);
+    }
+}
+
+void
+DistributionMapping::ComputeDistributionMappingEfficiency (const DistributionMapping& current,
+                                                           const DistributionMapping& proposed,
+                                                           const Vector<Real>& cost,
+                                                           const Vector<Long>& bytes,
+                                                           Real& currentEfficiency,
+                                                           Real& proposedEfficiency,
+                                                           Long& bytesMoved)
+{
+    BL_ASSERT(current.size() == proposed.size());
+
+    ComputeDistributionMappingEfficiency(current, cost, &currentEfficiency);
+    ComputeDistributionMappingEfficiency(proposed, cost, &proposedEfficiency);
+
+    bytesMoved = 0;
+    for (int i = 0; i < current.size(); ++i) {
+        if (current[i] != proposed[i]) bytesMoved += bytes[i];
+    }
+}
+
+DistributionMapping
+DistributionMapping::makeIncremental (const DistributionMapping& dm, const Vector<Real>& rcost,
+                                      const Vector<Long>& bytes, Long max_bytes,
+                                      Real& currentEfficiency, Real& proposedEfficiency,
+                                      Long& bytesMoved)
+{
+    BL_PROFILE("makeIncremental");
+
+    const int nprocs = ParallelDescriptor::NProcs();
+    const int N = dm.size();
+
+    AMREX_ALWAYS_ASSERT(static_cast<int>(rcost.size()) == N &&
+                        static_cast<int>(bytes.size()) == N);
+
+    Vector<int> pmap = dm.ProcessorMap();
+    Vector<Real> load(nprocs, 0.);
+    Vector<std::vector<int> > boxes_of(nprocs);
+    for (int i = 0; i < N; ++i) {
+        load[pmap[i]] += rcost[i];
+        boxes_of[pmap[i]].push_back(i);
+    }
+
+    // Processes ordered by load
+    std::set<std::pair<Real,int> > by_load;
+    for (int p = 0; p < nprocs; ++p) {
+        by_load.insert(std::make_pair(load[p], p));
+    }
+
+    Long budget = max_bytes;
+
+    //
+    // Every move lowers the sum of the squares of the loads, so this ends.
+    // The limit on the number of moves is only a safeguard.
+    //
+    for (int imove = 0; imove < 4*N && nprocs > 1; ++imove)
+    {
+        const int p = by_load.rbegin()->second;
+        const int q = by_load.begin()->second;
+        const Real diff = load[p] - load[q];
+        if (diff <= 0) break;
+
+        // The best box makes the two loads as close as possible.
+        int best = -1;
+        Real best_score = 0;
+        Long best_bytes = 0;
+        for (int i : boxes_of[p])
+        {
+            const Real w = rcost[i];
+            if (w <= 0 || w >= diff) continue;
+            const Long b = (pmap[i] == dm[i]) ? bytes[i] : 0L;
+            if (b > budget) continue;
+            const Real score = std::abs(w - 0.5*diff);
+            if (best < 0 || score < best_score || (score == best_score && b < best_bytes)) {
+                best = i;
+                best_score = score;
+                best_bytes = b;
+            }
+        }
+        if (best < 0) break;
+
+        budget -= best_bytes;
+        if (q == dm[best]) budget += bytes[best];
+
+        auto& bp = boxes_of[p];
+        bp.erase(std::find(bp.begin(), bp.end(), best));
+        boxes_of[q].push_back(best);
+        pmap[best] = q;
+
+        by_load.erase(std::make_pair(load[p], p));
+        by_load.erase(std::make_pair(load[q], q));
+        load[p] -= rcost[best];
+        load[q] += rcost[best];
+        by_load.insert(std::make_pair(load[p], p));
+        by_load.insert(std::make_pair(load[q], q));
+    }
+
+    DistributionMapping r(std::move(pmap));
+
+    ComputeDistributionMappingEfficiency(dm, r, rcost, bytes,
+                                         currentEfficiency, proposedEfficiency, bytesMoved);
+
+    if (verbose)
+    {
+        amrex::Print() << "Incremental efficiency: " << currentEfficiency << " -> "
+                       << proposedEfficiency << ", moving " << bytesMoved << " of at most "
+                       << max_bytes << " bytes\n";
+    }
+
+    return r;
+}
+
 namespace {
 Vector<Long>
 gather_weights (const MultiFab& weight)
@@ -1647,6 +2597,18 @@ DistributionMapping::makeKnapSack (const MultiFab& weight, Real& eff, int nmax)
     return r;
 }
 
+DistributionMapping
+DistributionMapping::makeIncremental (const MultiFab& weight, const Vector<Long>& bytes,
+                                      Long max_bytes, Real& currentEfficiency,
+                                      Real& proposedEfficiency, Long& bytesMoved)
+{
+    BL_PROFILE("makeIncremental");
+    Vector<Long> lcost = gather_weights(weight);
+    Vector<Real> rcost(lcost.begin(), lcost.end());
+    return makeIncremental(weight.DistributionMap(), rcost, bytes, max_bytes,
+                           currentEfficiency, proposedEfficiency, bytesMoved);
+}
+
 DistributionMapping
 DistributionMapping::makeRoundRobin (const MultiFab& weight)
 {
@@ -1726,6 +2688,54 @@ DistributionMapping::makeSFC (const Vector<Real>& rcost, const BoxArray& ba, Rea
     return r;
 }
 
+DistributionMapping
+DistributionMapping::makeSFC (const Vector<Vector<Real> >& rcosts, const BoxArray& ba,
+                              Vector<Real>& eff, bool sort)
+{
+    BL_PROFILE("makeSFC");
+
+    AMREX_ALWAYS_ASSERT(!rcosts.empty() && static_cast<int>(rcosts[0].size()) == ba.size());
+
+    const int nprocs = ParallelContext::NProcsSub();
+
+    if (ba.size() < sfc_threshold*nprocs)
+    {
+        return makeKnapSack(rcosts, eff, std::numeric_limits<int>::max(), sort);
+    }
+
+    DistributionMapping r;
+    r.m_ref->m_pmap.resize(ba.size());
+
+    r.SFCProcessorMapDoIt(ba, normalize_costs(rcosts), sort, eff);
+
+    return r;
+}
+
+DistributionMapping
+DistributionMapping::makeNodeSFC (const Vector<Real>& rcost, const BoxArray& ba, Real& eff,
+                                  bool sort)
+{
+    BL_PROFILE("makeNodeSFC");
+
+    AMREX_ALWAYS_ASSERT(static_cast<int>(rcost.size()) == ba.size());
+
+    std::vector<Long> cost(rcost.size());
+
+    Real wmax = *std::max_element(rcost.begin(), rcost.end());
+    Real scale = (wmax == 0) ? 1.e9 : 1.e9/wmax;
+
+    for (int i = 0; i < rcost.size(); ++i) {
+        cost[i] = Long(rcost[i]*scale) + 1L;
+    }
+
+    DistributionMapping r;
+    r.m_ref->m_pmap.resize(ba.size());
+
+    r.NodeSFCDoIt(ba, cost, sort, &eff);
+
+    return r;
+}
+
 DistributionMapping
 DistributionMapping::makeSFC (const LayoutData<Real>& rcost_local,
                               Real& currentEfficiency, Real& proposedEfficiency,
@@ -1798,23 +2808,17 @@ DistributionMapping::makeSFC (const BoxArray& ba, bool use_box_vol, const int np
     BL_PROFILE("makeSFC");
 
     const int N = ba.size();
-    std::vector<SFCToken> tokens;
     std::vector<Long> wgts;
-    tokens.reserve(N);
     wgts.reserve(N);
     Long vol_sum = 0;
     for (int i = 0; i < N; ++i)
     {
-        const Box& bx = ba[i];
-        tokens.push_back(makeSFCToken(i, bx.smallEnd()));
-        const Long v = use_box_vol ? bx.volume() : Long(1);
+        const Long v = use_box_vol ? ba[i].volume() : Long(1);
         vol_sum += v;
         wgts.push_back(v);
     }
-    //
-    // Put'm in Morton space filling curve order.
-    //
-    std::sort(tokens.begin(), tokens.end(), SFCToken::Compare());
+
+    std::vector<SFCToken> tokens = sfc_order(ba, m_Strategy == HILBERT);
 
     Real volper;
     volper = vol_sum / nprocs;
@@ -29,6 +29,8 @@ EArena::~EArena ()
 void*
 EArena::alloc (std::size_t nbytes)
 {
+    notify_alloc(nbytes);
+
     std::lock_guard<std::mutex> lock(earena_mutex);
 
     nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
@@ -1,10 +1,21 @@
 
 #include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <utility>
 #include <AMReX_FabArrayBase.H>
 #include <AMReX_ParmParse.H>
 #include <AMReX_Utility.H>
 #include <AMReX_Geometry.H>
 #include <AMReX_FArrayBox.H>
+#include <AMReX_MFIter.H>
+#include <AMReX_TileSizeTuner.H>
 #include <AMReX_NonLocalBC.H>
 
 #include <AMReX_BArena.H>
@@ -25,6 +36,9 @@ namespace amrex {
 // Set default values in Initialize()!!!
 //
 int     FabArrayBase::MaxComp;
+bool    FabArrayBase::use_persistent_fb = false;
+bool    FabArrayBase::use_neighbor_collective = false;
+bool    FabArrayBase::use_node_shm = false;
 
 #if defined(AMREX_USE_GPU)
 
@@ -48,6 +62,11 @@ IntVect FabArrayBase::mfiter_tile_size(1024000,8,8);
 
 #endif
 
+bool FabArrayBase::mfiter_work_stealing = false;
+bool FabArrayBase::mfiter_thread_stats  = false;
+bool FabArrayBase::mfiter_sfc_tiles     = false;
+bool FabArrayBase::print_cache_stats    = false;
+
 #if defined(AMREX_USE_GPU) || !defined(_OPENMP)
 IntVect FabArrayBase::comm_tile_size(AMREX_D_DECL(1024000, 1024000, 1024000));
 IntVect FabArrayBase::mfghostiter_tile_size(AMREX_D_DECL(1024000, 1024000, 1024000));
@@ -71,17 +90,209 @@ FabArrayBase::CacheStats           FabArrayBase::m_CPC_stats("CopyCache");
 FabArrayBase::CacheStats           FabArrayBase::m_FPinfo_stats("FillPatchCache");
 FabArrayBase::CacheStats           FabArrayBase::m_CFinfo_stats("CrseFineCache");
 
+FabArrayBase::LRUList<FabArrayBase::FB>     FabArrayBase::m_FBC_lru;
+FabArrayBase::LRUList<FabArrayBase::CPC>    FabArrayBase::m_CPC_lru;
+FabArrayBase::LRUList<FabArrayBase::FPinfo> FabArrayBase::m_FPinfo_lru;
+FabArrayBase::LRUList<FabArrayBase::CFinfo> FabArrayBase::m_CFinfo_lru;
+
 std::map<FabArrayBase::BDKey, int> FabArrayBase::m_BD_count;
 
 FabArrayBase::FabArrayStats        FabArrayBase::m_FA_stats;
 
 std::map<std::string,FabArrayBase::meminfo> FabArrayBase::m_mem_usage;
 std::vector<std::string>                    FabArrayBase::m_region_tag;
+bool                                        FabArrayBase::m_mem_trace = false;
 
 namespace
 {
     Arena* the_fa_arena = nullptr;
     bool initialized = false;
+
+    std::string mem_trace_file("mem_trace");
+
+    constexpr int mem_trace_nbins = 64;
+
+    struct MemTraceInfo
+    {
+        Long nbytes = 0L;
+        Long nbytes_hwm = 0L;
+        Long nbytes_step_hwm = 0L; // peak since the last memTraceStep
+    };
+
+    struct MemTraceEntry
+    {
+        int id;
+        Long nbytes;
+        Long nbytes_peak;
+    };
+
+    struct MemTraceRecord
+    {
+        Long step;
+        double time;
+        std::vector<MemTraceEntry> entries;
+    };
+
+    // Names of tags and arenas, and the index of their info.
+    std::vector<std::string> mem_trace_names;
+    std::map<std::string,int> mem_trace_ids;
+    std::vector<MemTraceInfo> mem_trace_info;
+    std::vector<MemTraceRecord> mem_trace_records;
+    std::map<Arena const*,int> mem_trace_arena_ids;
+    // Arena::alloc sizes in log2 bins, per (region tag, arena) index
+    std::map<std::pair<int,int>,std::array<Long,mem_trace_nbins> > mem_trace_hists;
+    // The Arena::alloc hook can be called by several threads.
+    std::mutex mem_trace_mutex;
+
+    int mem_trace_id (std::string const& name)
+    {
+        auto it = mem_trace_ids.find(name);
+        if (it == mem_trace_ids.end()) {
+            int id = mem_trace_names.size();
+            mem_trace_names.push_back(name);
+            mem_trace_info.emplace_back();
+            it = mem_trace_ids.emplace(name, id).first;
+        }
+        return it->second;
+    }
+
+    MemTraceInfo& mem_trace_get (std::string const& name)
+    {
+        return mem_trace_info[mem_trace_id(name)];
+    }
+
+    void mem_trace_update (std::string const& name, Long nbytes)
+    {
+        MemTraceInfo& mi = mem_trace_get(name);
+        mi.nbytes += nbytes;
+        mi.nbytes_hwm = std::max(mi.nbytes, mi.nbytes_hwm);
+        mi.nbytes_step_hwm = std::max(mi.nbytes, mi.nbytes_step_hwm);
+    }
+
+    std::string mem_trace_arena_name (Arena const* ar)
+    {
+        if (ar == nullptr || ar == The_Arena()) {
+            return "Arena:The_Arena";
+        } else if (ar == The_Device_Arena()) {
+            return "Arena:The_Device_Arena";
+        } else if (ar == The_Managed_Arena()) {
+            return "Arena:The_Managed_Arena";
+        } else if (ar == The_Pinned_Arena()) {
+            return "Arena:The_Pinned_Arena";
+        } else if (ar == The_Cpu_Arena()) {
+            return "Arena:The_Cpu_Arena";
+        } else if (ar == The_Step_Arena()) {
+            return "Arena:The_Step_Arena";
+        } else {
+            std::ostringstream ss;
+            ss << "Arena:" << static_cast<void const*>(ar);
+            return ss.str();
+        }
+    }
+
+    // Arena::alloc hook: count every allocation in the histograms of its
+    // arena under "All" and under each region tag, like the FabArrays.
+    void mem_trace_alloc (Arena const* ar, std::size_t nbytes)
+    {
+        int b = 0;
+        for (std::size_t n = nbytes; n >>= 1; ) { ++b; }
+        std::lock_guard<std::mutex> lock(mem_trace_mutex);
+        auto it = mem_trace_arena_ids.find(ar);
+        if (it == mem_trace_arena_ids.end()) {
+            it = mem_trace_arena_ids.emplace(ar, mem_trace_id(mem_trace_arena_name(ar))).first;
+        }
+        const int arena_id = it->second;
+        ++mem_trace_hists[std::make_pair(mem_trace_id("All"), arena_id)][b];
+        for (auto const& t : FabArrayBase::m_region_tag) {
+            ++mem_trace_hists[std::make_pair(mem_trace_id(t), arena_id)][b];
+        }
+    }
+
+    template <typename T>
+    void mem_trace_write (std::ostream& os, T const& v)
+    {
+        os.write(reinterpret_cast<char const*>(&v), sizeof(T));
+    }
+
+    // Put a new item at the end of the LRU order of its cache.
+    template <class T>
+    void insertLRU (FabArrayBase::LRUList<T>& lru, T* p,
+                    FabArrayBase::BDKey const& key0, FabArrayBase::BDKey const& key1)
+    {
+        p->m_lru = lru.insert(lru.end(), FabArrayBase::LRUEntry<T>{p, {key0, key1}});
+    }
+
+    // Move a used item to the end of the LRU order of its cache.
+    template <class T>
+    void touchLRU (FabArrayBase::LRUList<T>& lru, T* p)
+    {
+        lru.splice(lru.end(), lru, p->m_lru);
+    }
+
+    // Evict the least recently used items of a cache until it is within
+    // its byte budget.  The item just built and the pinned items are kept,
+    // and moved to the end of the order so that each is looked at once.
+    // Items that own MPI resources are pinned, because they have to be in
+    // the same state on all processes, whereas the bytes of a cache are
+    // different.  So are the items of non-blocking calls in progress.
+    template <class C, class T, class F>
+    void evictLRU (C& cache, FabArrayBase::LRUList<T>& lru, FabArrayBase::CacheStats& stats,
+                   T const* keep, F&& pinned)
+    {
+        if (stats.budget <= 0) return;
+        std::size_t nkept = 0;
+        while (stats.bytes > stats.budget && nkept < lru.size())
+        {
+            const FabArrayBase::LRUEntry<T> e = lru.front();
+            T* victim = e.item;
+            if (victim == keep || pinned(*victim)) {
+                lru.splice(lru.end(), lru, lru.begin());
+                ++nkept;
+                continue;
+            }
+            lru.pop_front();
+
+            for (int i = 0; i < 2; ++i) {
+                if (i == 1 && e.key[1] == e.key[0]) break;
+                auto er_it = cache.equal_range(e.key[i]);
+                for (auto it = er_it.first; it != er_it.second; ++it) {
+                    if (it->second == victim) {
+                        cache.erase(it);
+                        break;
+                    }
+                }
+            }
+            const Long nbytes = victim->bytes();
+            stats.bytes -= nbytes;
+            stats.recordEvict(victim->m_nuse, nbytes);
+            delete victim;
+        }
+    }
+
+    //
+    // Sort idx along a Hilbert curve through the points pt(idx[n]).
+    //
+    template <class F>
+    void hilbert_sort (std::vector<int>& idx, F const& pt)
+    {
+        const int n = idx.size();
+        if (n < 2) return;
+
+        Vector<IntVect> x(n);
+        for (int i = 0; i < n; ++i) {
+            x[i] = pt(idx[i]);
+        }
+        const Vector<std::uint64_t> h = HilbertIndices(x);
+
+        std::vector<std::pair<std::uint64_t,int> > keys(n);
+        for (int i = 0; i < n; ++i) {
+            keys[i] = std::make_pair(h[i], idx[i]);
+        }
+        std::sort(keys.begin(), keys.end());
+        for (int i = 0; i < n; ++i) {
+            idx[i] = keys[i].second;
+        }
+    }
 }
 
 void
@@ -114,7 +325,27 @@ FabArrayBase::Initialize ()
         for (int i=0; i<AMREX_SPACEDIM; i++) FabArrayBase::comm_tile_size[i] = tilesize[i];
     }
 
+    pp.query("mfiter_work_stealing", FabArrayBase::mfiter_work_stealing);
+    pp.query("mfiter_thread_stats", FabArrayBase::mfiter_thread_stats);
+    pp.query("mfiter_sfc_tiles", FabArrayBase::mfiter_sfc_tiles);
+    MFIter::ResetThreadStatistics();
+    TileSizeTuner::Initialize();
+
     pp.query("maxcomp",             FabArrayBase::MaxComp);
+    pp.query("use_persistent_fb",   FabArrayBase::use_persistent_fb);
+    pp.query("use_neighbor_collective", FabArrayBase::use_neighbor_collective);
+    pp.query("use_node_shm",        FabArrayBase::use_node_shm);
+    pp.query("mem_trace",           FabArrayBase::m_mem_trace);
+    pp.query("fb_cache_budget",     m_FBC_stats.budget);
+    pp.query("cpc_cache_budget",    m_CPC_stats.budget);
+    pp.query("fpinfo_cache_budget", m_FPinfo_stats.budget);
+    pp.query("cfinfo_cache_budget", m_CFinfo_stats.budget);
+    pp.query("print_cache_stats",   FabArrayBase::print_cache_stats);
+    pp.query("mem_trace_file",      mem_trace_file);
+
+    if (m_mem_trace) {
+        Arena::SetAllocHook(mem_trace_alloc);
+    }
 
     if (MaxComp < 1) {
         MaxComp = 1;
@@ -543,10 +774,9 @@ FabArrayBase::flushCPC (bool no_assertion) const
 	    }
 	}
 
-#ifdef AMREX_MEM_PROFILING
 	m_CPC_stats.bytes -= it->second->bytes();
-#endif
 	m_CPC_stats.recordErase(it->second->m_nuse);
+	m_CPC_lru.erase(it->second->m_lru);
 	delete it->second;
     }
 
@@ -570,9 +800,8 @@ FabArrayBase::flushCPCache ()
 	}
     }
     m_TheCPCache.clear();
-#ifdef AMREX_MEM_PROFILING
+    m_CPC_lru.clear();
     m_CPC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::CPC&
@@ -600,6 +829,7 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
 	    it->second->m_dstba  == boxArray())
 	{
 	    ++(it->second->m_nuse);
+	    touchLRU(m_CPC_lru, it->second);
 	    m_CPC_stats.recordUse();
 	    return *(it->second);
 	}
@@ -608,12 +838,11 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     // Have to build a new one
     CPC* new_cpc = new CPC(*this, dstng, src, srcng, period);
 
-#ifdef AMREX_MEM_PROFILING
-    m_CPC_stats.bytes += new_cpc->bytes();
-    m_CPC_stats.bytes_hwm = std::max(m_CPC_stats.bytes_hwm, m_CPC_stats.bytes);
-#endif    
+    m_CPC_stats.recordBytes(new_cpc->bytes());
 
     new_cpc->m_nuse = 1;
+
+    insertLRU(m_CPC_lru, new_cpc, dstkey, srckey);
     m_CPC_stats.recordBuild();
     m_CPC_stats.recordUse();
 
@@ -621,6 +850,9 @@ FabArrayBase::getCPC (const IntVect& dstng, const FabArrayBase& src, const IntVe
     if (srckey != dstkey)
 	m_TheCPCache.insert(          CPCache::value_type(srckey,new_cpc));
 
+    evictLRU(m_TheCPCache, m_CPC_lru, m_CPC_stats, new_cpc,
+             [] (CPC const& x) { return x.hasNeighborComm(); });
+
     return *new_cpc;
 }
 
@@ -1044,6 +1276,143 @@ FabArrayBase::FB::define_epo (const FabArrayBase& fa)
 FabArrayBase::FB::~FB ()
 {}
 
+constexpr int FabArrayBase::FB::max_persistent;
+
+FabArrayBase::CommMetaData::~CommMetaData ()
+{
+#ifdef BL_USE_MPI
+    if (m_nbr_comm != MPI_COMM_NULL) {
+        int finalized;
+        MPI_Finalized(&finalized);
+        if (!finalized) MPI_Comm_free(&m_nbr_comm);
+    }
+#endif
+}
+
+MPI_Comm
+FabArrayBase::CommMetaData::getNeighborComm () const
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    MPI_Comm comm = ParallelContext::CommunicatorSub();
+    if (m_nbr_comm != MPI_COMM_NULL && m_nbr_parent == comm) {
+        return m_nbr_comm;
+    }
+
+    BL_PROFILE("FabArrayBase::getNeighborComm()");
+
+    if (m_nbr_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_nbr_comm);
+    }
+
+    Vector<int> srcs, dsts;
+    for (auto const& kv : *m_RcvTags) {
+        srcs.push_back(ParallelContext::global_to_local_rank(kv.first));
+    }
+    for (auto const& kv : *m_SndTags) {
+        dsts.push_back(ParallelContext::global_to_local_rank(kv.first));
+    }
+
+    BL_MPI_REQUIRE( MPI_Dist_graph_create_adjacent(comm,
+                                                   srcs.size(), srcs.dataPtr(), MPI_UNWEIGHTED,
+                                                   dsts.size(), dsts.dataPtr(), MPI_UNWEIGHTED,
+                                                   MPI_INFO_NULL, 0, &m_nbr_comm) );
+    m_nbr_parent = comm;
+    return m_nbr_comm;
+#else
+    amrex::Abort("FabArrayBase::getNeighborComm: MPI-3 is required");
+    return MPI_COMM_NULL;
+#endif
+}
+
+const FabArrayBase::CommMetaData::NodeSplit&
+FabArrayBase::CommMetaData::getNodeSplit () const
+{
+    if (!m_node_split)
+    {
+        m_node_split.reset(new NodeSplit);
+        for (auto const& kv : *m_SndTags) {
+            if (ParallelDescriptor::RankInNode(kv.first) < 0) {
+                m_node_split->m_SndTags.insert(kv);
+            }
+        }
+        for (auto const& kv : *m_RcvTags) {
+            if (ParallelDescriptor::RankInNode(kv.first) < 0) {
+                m_node_split->m_RcvTags.insert(kv);
+            } else {
+                auto& tags = m_node_split->m_NodeTags;
+                tags.insert(tags.end(), kv.second.begin(), kv.second.end());
+            }
+        }
+    }
+    return *m_node_split;
+}
+
+namespace {
+    FabArrayBase::CommVolume
+    comm_volume (const FabArrayBase::CommMetaData& cmd)
+    {
+        FabArrayBase::CommVolume r;
+        if (cmd.m_LocTags) {
+            for (auto const& tag : *cmd.m_LocTags) {
+                r.local += tag.dbox.numPts();
+            }
+        }
+        if (cmd.m_SndTags) {
+            const int mynode = DistributionMapping::NodeOf(ParallelDescriptor::MyProc());
+            for (auto const& kv : *cmd.m_SndTags) {
+                Long n = 0;
+                for (auto const& tag : kv.second) {
+                    n += tag.sbox.numPts();
+                }
+                if (DistributionMapping::NodeOf(kv.first) == mynode) {
+                    r.on_node += n;
+                } else {
+                    r.off_node += n;
+                }
+            }
+        }
+        Long v[3] = {r.local, r.on_node, r.off_node};
+        ParallelAllReduce::Sum(v, 3, ParallelContext::CommunicatorSub());
+        r.local = v[0];
+        r.on_node = v[1];
+        r.off_node = v[2];
+        return r;
+    }
+}
+
+FabArrayBase::CommVolume
+FabArrayBase::FBCommVolume (const IntVect& nghost, const Periodicity& period, bool cross) const
+{
+    return comm_volume(getFB(nghost, period, cross));
+}
+
+FabArrayBase::CommVolume
+FabArrayBase::CPCCommVolume (const FabArrayBase& src, const IntVect& srcng,
+                             const IntVect& dstng, const Periodicity& period) const
+{
+    return comm_volume(getCPC(dstng, src, srcng, period));
+}
+
+FabArrayBase::FB::PersistentComm::~PersistentComm ()
+{
+    BL_ASSERT(!in_use);
+#ifdef BL_USE_MPI
+    for (auto& r : send_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+    for (auto& r : recv_reqs) {
+        if (r != MPI_REQUEST_NULL) MPI_Request_free(&r);
+    }
+    if (msg_comm != MPI_COMM_NULL) {
+        int finalized = 0;
+        MPI_Finalized(&finalized);
+        if (!finalized) MPI_Comm_free(&msg_comm);
+    }
+#endif
+    if (the_send_data) amrex::The_FA_Arena()->free(the_send_data);
+    if (the_recv_data) amrex::The_FA_Arena()->free(the_recv_data);
+}
+
 void
 FabArrayBase::flushFB (bool no_assertion) const
 {
@@ -1052,10 +1421,9 @@ FabArrayBase::flushFB (bool no_assertion) const
     std::pair<FBCacheIter,FBCacheIter> er_it = m_TheFBCache.equal_range(m_bdkey);
     for (FBCacheIter it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef AMREX_MEM_PROFILING
 	m_FBC_stats.bytes -= it->second->bytes();
-#endif
 	m_FBC_stats.recordErase(it->second->m_nuse);
+	m_FBC_lru.erase(it->second->m_lru);
 	delete it->second;
     }
     m_TheFBCache.erase(er_it.first, er_it.second);
@@ -1070,9 +1438,8 @@ FabArrayBase::flushFBCache ()
 	delete it->second;
     }
     m_TheFBCache.clear();
-#ifdef AMREX_MEM_PROFILING
+    m_FBC_lru.clear();
     m_FBC_stats.bytes = 0L;
-#endif
 }
 
 const FabArrayBase::FB&
@@ -1094,6 +1461,7 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
 	    it->second->m_period     == period              )
 	{
 	    ++(it->second->m_nuse);
+	    touchLRU(m_FBC_lru, it->second);
 	    m_FBC_stats.recordUse();
 	    return *(it->second);
 	}
@@ -1102,17 +1470,21 @@ FabArrayBase::getFB (const IntVect& nghost, const Periodicity& period,
     // Have to build a new one
     FB* new_fb = new FB(*this, nghost, cross, period, enforce_periodicity_only,m_multi_ghost);
 
-#ifdef AMREX_MEM_PROFILING
-    m_FBC_stats.bytes += new_fb->bytes();
-    m_FBC_stats.bytes_hwm = std::max(m_FBC_stats.bytes_hwm, m_FBC_stats.bytes);
-#endif
+    m_FBC_stats.recordBytes(new_fb->bytes());
 
     new_fb->m_nuse = 1;
+
+    insertLRU(m_FBC_lru, new_fb, m_bdkey, m_bdkey);
     m_FBC_stats.recordBuild();
     m_FBC_stats.recordUse();
 
     m_TheFBCache.insert(er_it.second, FBCache::value_type(m_bdkey,new_fb));
 
+    evictLRU(m_TheFBCache, m_FBC_lru, m_FBC_stats, new_fb,
+             [] (FB const& x) {
+                 return x.hasNeighborComm() || !x.m_persistent.empty() || x.m_nflight > 0;
+             });
+
     return *new_fb;
 }
 
@@ -1864,6 +2236,7 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
 	    it->second->m_coarsener->doit(it->second->m_dstdomain) == coarsener.doit(dstdomain))
 	{
 	    ++(it->second->m_nuse);
+	    touchLRU(m_FPinfo_lru, it->second);
 	    m_FPinfo_stats.recordUse();
 	    return *(it->second);
 	}
@@ -1873,12 +2246,11 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     FPinfo* new_fpc = new FPinfo(srcfa, dstfa, dstdomain, dstng, coarsener,
                                  fgeom.Domain(), cgeom.Domain(), index_space);
 
-#ifdef AMREX_MEM_PROFILING
-    m_FPinfo_stats.bytes += new_fpc->bytes();
-    m_FPinfo_stats.bytes_hwm = std::max(m_FPinfo_stats.bytes_hwm, m_FPinfo_stats.bytes);
-#endif
+    m_FPinfo_stats.recordBytes(new_fpc->bytes());
     
     new_fpc->m_nuse = 1;
+    
+    insertLRU(m_FPinfo_lru, new_fpc, dstkey, srckey);
     m_FPinfo_stats.recordBuild();
     m_FPinfo_stats.recordUse();
 
@@ -1886,6 +2258,9 @@ FabArrayBase::TheFPinfo (const FabArrayBase& srcfa,
     if (srckey != dstkey)
 	m_TheFillPatchCache.insert(          FPinfoCache::value_type(srckey,new_fpc));
 
+    evictLRU(m_TheFillPatchCache, m_FPinfo_lru, m_FPinfo_stats, new_fpc,
+             [] (FPinfo const&) { return false; });
+
     return *new_fpc;
 }
 
@@ -1918,10 +2293,9 @@ FabArrayBase::flushFPinfo (bool no_assertion)
 	    }
 	} 
 
-#ifdef AMREX_MEM_PROFILING
 	m_FPinfo_stats.bytes -= it->second->bytes();
-#endif
 	m_FPinfo_stats.recordErase(it->second->m_nuse);
+	m_FPinfo_lru.erase(it->second->m_lru);
 	delete it->second;
     }
     
@@ -2027,6 +2401,7 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
             it->second->m_ng          == ng)
         {
             ++(it->second->m_nuse);
+            touchLRU(m_CFinfo_lru, it->second);
             m_CFinfo_stats.recordUse();
             return *(it->second);
         }
@@ -2035,17 +2410,19 @@ FabArrayBase::TheCFinfo (const FabArrayBase& finefa,
     // Have to build a new one
     CFinfo* new_cfinfo = new CFinfo(finefa, finegm, ng, include_periodic, include_physbndry);
 
-#ifdef AMREX_MEM_PROFILING
-    m_CFinfo_stats.bytes += new_cfinfo->bytes();
-    m_CFinfo_stats.bytes_hwm = std::max(m_CFinfo_stats.bytes_hwm, m_CFinfo_stats.bytes);
-#endif
+    m_CFinfo_stats.recordBytes(new_cfinfo->bytes());
 
     new_cfinfo->m_nuse = 1;
+
+    insertLRU(m_CFinfo_lru, new_cfinfo, key, key);
     m_CFinfo_stats.recordBuild();
     m_CFinfo_stats.recordUse();
 
     m_TheCrseFineCache.insert(er_it.second, CFinfoCache::value_type(key,new_cfinfo));
 
+    evictLRU(m_TheCrseFineCache, m_CFinfo_lru, m_CFinfo_stats, new_cfinfo,
+             [] (CFinfo const&) { return false; });
+
     return *new_cfinfo;
 }
 
@@ -2057,15 +2434,70 @@ FabArrayBase::flushCFinfo (bool no_assertion)
     auto er_it = m_TheCrseFineCache.equal_range(m_bdkey);
     for (auto it = er_it.first; it != er_it.second; ++it)
     {
-#ifdef AMREX_MEM_PROFILING
         m_CFinfo_stats.bytes -= it->second->bytes();
-#endif
         m_CFinfo_stats.recordErase(it->second->m_nuse);
+        m_CFinfo_lru.erase(it->second->m_lru);
         delete it->second;
     }
     m_TheCrseFineCache.erase(er_it.first, er_it.second);
 }
 
+void
+FabArrayBase::printCacheStats ()
+{
+    if (!initialized) return;
+
+    const int ncaches = 5;
+    CacheStats const* stats[ncaches] = {&m_FBC_stats, &m_CPC_stats, &m_FPinfo_stats,
+                                        &m_CFinfo_stats, &m_TAC_stats};
+    const int nvals = 5;
+    Vector<Long> vmax, vmin;
+    for (int i = 0; i < ncaches; ++i) {
+        for (Long v : {stats[i]->nhit(), stats[i]->nmiss(), stats[i]->nevict,
+                    stats[i]->bytes_hwm, stats[i]->bytes_evicted})
+        {
+            vmax.push_back(v);
+        }
+    }
+    vmin = vmax;
+
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Max(vmax.data(), vmax.size(), IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Min(vmin.data(), vmin.size(), IOProc, ParallelDescriptor::Communicator());
+
+    if (ParallelDescriptor::IOProcessor())
+    {
+        amrex::Print() << "\nCommunication cache statistics [min ... max] over processes\n"
+                       << std::setw(16) << std::left << "Cache"
+                       << std::setw(24) << std::right << "Hits"
+                       << std::setw(24) << "Misses"
+                       << std::setw(20) << "Evictions"
+                       << std::setw(32) << "Max bytes"
+                       << "\n";
+        for (int i = 0; i < ncaches; ++i) {
+            auto range = [&] (int j) {
+                return std::to_string(vmin[i*nvals+j]) + " ... " + std::to_string(vmax[i*nvals+j]);
+            };
+            amrex::Print() << std::setw(16) << std::left << stats[i]->name
+                           << std::setw(24) << std::right << range(0)
+                           << std::setw(24) << range(1)
+                           << std::setw(20) << range(2)
+                           << std::setw(32) << range(3)
+                           << "\n";
+        }
+        if (m_FBC_stats.budget > 0 || m_CPC_stats.budget > 0 ||
+            m_FPinfo_stats.budget > 0 || m_CFinfo_stats.budget > 0)
+        {
+            amrex::Print() << "Bytes evicted [min ... max]:";
+            for (int i = 0; i < ncaches-1; ++i) {
+                amrex::Print() << " " << stats[i]->name << ": "
+                               << vmin[i*nvals+4] << " ... " << vmax[i*nvals+4] << ";";
+            }
+            amrex::Print() << "\n";
+        }
+    }
+}
+
 void
 FabArrayBase::Finalize ()
 {
@@ -2090,6 +2522,18 @@ FabArrayBase::Finalize ()
     }
     m_region_tag.clear();
 
+    if (m_mem_trace) {
+        Arena::SetAllocHook(nullptr);
+        memTraceStep(-1);
+        writeMemTrace(mem_trace_file + "." + std::to_string(ParallelDescriptor::MyProc()));
+        mem_trace_names.clear();
+        mem_trace_ids.clear();
+        mem_trace_info.clear();
+        mem_trace_records.clear();
+        mem_trace_arena_ids.clear();
+        mem_trace_hists.clear();
+    }
+
     m_TAC_stats = CacheStats("TileArrayCache");
     m_FBC_stats = CacheStats("FBCache");
     m_CPC_stats = CacheStats("CopyCache");
@@ -2167,6 +2611,13 @@ FabArrayBase::buildTileArray (const IntVect& tileSize, TileArray& ta) const
 	std::vector<int> local_idxs(N);
 	std::iota(std::begin(local_idxs), std::end(local_idxs), 0);
 
+        if (mfiter_sfc_tiles) {
+            hilbert_sort(local_idxs, [this] (int i) {
+                const Box& b = boxarray.getCellCenteredBox(indexArray[i]);
+                return (b.smallEnd() + b.bigEnd()) / 2;
+            });
+        }
+
 #if defined(BL_USE_TEAM)
 	const int nworkers = ParallelDescriptor::TeamSize();
 	if (nworkers > 1) {
@@ -2177,6 +2628,7 @@ FabArrayBase::buildTileArray (const IntVect& tileSize, TileArray& ta) const
 	}
 #endif	
 
+	std::vector<int> tile_order;
 	for (std::vector<int>::const_iterator it = local_idxs.begin(); it != local_idxs.end(); ++it)
 	{
 	    const int i = *it;         // local index 
@@ -2196,24 +2648,31 @@ FabArrayBase::buildTileArray (const IntVect& tileSize, TileArray& ta) const
 		nleft    [d] = ncells - nt_in_fab[d]*tsize[d];
 		ntiles *= nt_in_fab[d];
 	    }
-	    
-	    IntVect small, big, ijk;  // note that the initial values are all zero.
-	    ijk[0] = -1;
-	    for (int t = 0; t < ntiles; ++t) {
+
+            // Position of tile t in the FAB, with the x-direction the fastest
+            auto tile_ijk = [&nt_in_fab] (int t) -> IntVect {
+                IntVect ijk;
+                for (int d=0; d<AMREX_SPACEDIM; d++) {
+                    ijk[d] = t % nt_in_fab[d];
+                    t /= nt_in_fab[d];
+                }
+                return ijk;
+            };
+
+            tile_order.resize(ntiles);
+            std::iota(tile_order.begin(), tile_order.end(), 0);
+            if (mfiter_sfc_tiles) {
+                hilbert_sort(tile_order, tile_ijk);
+            }
+
+	    IntVect small, big;
+	    for (int t : tile_order) {
 		ta.indexMap.push_back(K);
 		ta.localIndexMap.push_back(i);
 		ta.localTileIndexMap.push_back(t);
 		ta.numLocalTiles.push_back(ntiles);
 
-		for (int d=0; d<AMREX_SPACEDIM; d++) {
-		    if (ijk[d]<nt_in_fab[d]-1) {
-			ijk[d]++;
-			break;
-		    } else {
-			ijk[d] = 0;
-		    }
-		}
-		
+		const IntVect ijk = tile_ijk(t);
 		for (int d=0; d<AMREX_SPACEDIM; d++) {
 		    if (ijk[d] < nleft[d]) {
 			small[d] = ijk[d]*(tsize[d]+1);
@@ -2419,11 +2878,96 @@ operator<< (std::ostream& os, const FabArrayBase::BDKey& id)
 }
 
 void
-FabArrayBase::updateMemUsage (std::string const& tag, Long nbytes, Arena const* /*ar*/)
+FabArrayBase::updateMemUsage (std::string const& tag, Long nbytes, Arena const* ar)
 {
     auto& mi = m_mem_usage[tag];
     mi.nbytes += nbytes;
     mi.nbytes_hwm = std::max(mi.nbytes, mi.nbytes_hwm);
+
+    if (m_mem_trace) {
+        std::lock_guard<std::mutex> lock(mem_trace_mutex);
+        mem_trace_update(tag, nbytes);
+        // Every FabArray is counted under "All" exactly once, so that is
+        // where the usage per arena is updated.
+        if (tag == "All") {
+            mem_trace_update(mem_trace_arena_name(ar), nbytes);
+        }
+    }
+}
+
+void
+FabArrayBase::memTraceStep (Long step)
+{
+    if (!m_mem_trace) return;
+
+    std::lock_guard<std::mutex> lock(mem_trace_mutex);
+    MemTraceRecord rec;
+    rec.step = step;
+    rec.time = amrex::second();
+    for (int id = 0, N = mem_trace_info.size(); id < N; ++id) {
+        MemTraceInfo& mi = mem_trace_info[id];
+        if (mi.nbytes != 0 || mi.nbytes_step_hwm != 0) {
+            rec.entries.push_back({id, mi.nbytes, mi.nbytes_step_hwm});
+        }
+        mi.nbytes_step_hwm = mi.nbytes;
+    }
+    mem_trace_records.push_back(std::move(rec));
+}
+
+//
+// Binary layout, native endianness:
+//   char[8] "AMRXMTR2", int32 rank, int32 nprocs,
+//   int32 nnames, then per name: int32 length and the characters,
+//   per name: int64 hwm,
+//   int32 nhists, then per histogram: int32 tag name index, int32 arena
+//     name index and int64[64] counts of the Arena::alloc calls of size
+//     [2^b, 2^(b+1)) bytes while the tag was active ("All" for all calls),
+//   int64 nrecords, then per record: int64 step (-1 at Finalize),
+//     double time, int32 nentries, and per entry: int32 name index,
+//     int64 current bytes, int64 peak bytes since the previous record.
+//
+void
+FabArrayBase::writeMemTrace (std::string const& file)
+{
+    std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+    if (!ofs.good()) {
+        amrex::FileOpenFailed(file);
+    }
+
+    ofs.write("AMRXMTR2", 8);
+    mem_trace_write(ofs, static_cast<std::int32_t>(ParallelDescriptor::MyProc()));
+    mem_trace_write(ofs, static_cast<std::int32_t>(ParallelDescriptor::NProcs()));
+
+    mem_trace_write(ofs, static_cast<std::int32_t>(mem_trace_names.size()));
+    for (auto const& name : mem_trace_names) {
+        mem_trace_write(ofs, static_cast<std::int32_t>(name.size()));
+        ofs.write(name.data(), name.size());
+    }
+
+    for (auto const& mi : mem_trace_info) {
+        mem_trace_write(ofs, static_cast<std::int64_t>(mi.nbytes_hwm));
+    }
+
+    mem_trace_write(ofs, static_cast<std::int32_t>(mem_trace_hists.size()));
+    for (auto const& kv : mem_trace_hists) {
+        mem_trace_write(ofs, static_cast<std::int32_t>(kv.first.first));
+        mem_trace_write(ofs, static_cast<std::int32_t>(kv.first.second));
+        for (auto n : kv.second) {
+            mem_trace_write(ofs, static_cast<std::int64_t>(n));
+        }
+    }
+
+    mem_trace_write(ofs, static_cast<std::int64_t>(mem_trace_records.size()));
+    for (auto const& rec : mem_trace_records) {
+        mem_trace_write(ofs, static_cast<std::int64_t>(rec.step));
+        mem_trace_write(ofs, rec.time);
+        mem_trace_write(ofs, static_cast<std::int32_t>(rec.entries.size()));
+        for (auto const& e : rec.entries) {
+            mem_trace_write(ofs, static_cast<std::int32_t>(e.id));
+            mem_trace_write(ofs, static_cast<std::int64_t>(e.nbytes));
+            mem_trace_write(ofs, static_cast<std::int64_t>(e.nbytes_peak));
+        }
+    }
 }
 
 void
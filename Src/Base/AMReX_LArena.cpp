@@ -0,0 +1,160 @@
+
+#include <AMReX_LArena.H>
+#include <AMReX_BLassert.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_Print.H>
+#include <AMReX.H>
+
+#include <algorithm>
+
+namespace amrex {
+
+LArena::LArena (std::size_t capacity, Arena* fallback, ArenaInfo info)
+    : m_fallback(fallback),
+      m_capacity(Arena::align(capacity))
+{
+    arena_info = info;
+    if (m_capacity > 0) {
+        m_baseptr = static_cast<char*>(allocate_system(m_capacity));
+    }
+}
+
+LArena::~LArena ()
+{
+    if (m_baseptr) {
+        deallocate_system(m_baseptr, m_capacity);
+    }
+}
+
+void*
+LArena::alloc (std::size_t nbytes)
+{
+    const std::size_t nrequest = nbytes;
+    nbytes = Arena::align(nbytes == 0 ? 1 : nbytes);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_offset + nbytes <= m_capacity) {
+            void* p = m_baseptr + m_offset;
+            m_offset += nbytes;
+            m_hwm = std::max(m_hwm, m_offset);
+            m_live.insert(m_live.end(), m_offset - nbytes);
+            notify_alloc(nrequest);
+            return p;
+        }
+    }
+
+    // The fallback arena reports this allocation to the alloc hook.
+    Arena* ar = m_fallback ? m_fallback : The_Arena();
+    void* p = ar->alloc(nbytes);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_num_fallbacks;
+    m_fallback_ptrs.insert(p);
+    return p;
+}
+
+void
+LArena::free (void* p)
+{
+    if (p == nullptr) return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    char* cp = static_cast<char*>(p);
+    if (cp >= m_baseptr && cp < m_baseptr + m_capacity) {
+        if (m_live.erase(cp - m_baseptr) == 0) {
+            amrex::Abort("LArena::free: pointer not in use");
+        }
+        return;
+    }
+
+    auto it = m_fallback_ptrs.find(p);
+    if (it == m_fallback_ptrs.end()) {
+        amrex::Abort("LArena::free: unknown pointer");
+    }
+    m_fallback_ptrs.erase(it);
+    lock.unlock();
+
+    Arena* ar = m_fallback ? m_fallback : The_Arena();
+    ar->free(p);
+}
+
+void
+LArena::reset ()
+{
+    rewind(0);
+}
+
+bool
+LArena::inUseAbove (std::size_t offset) const
+{
+    // The blocks are handed out at increasing offsets, so the last one
+    // in use is the highest.
+    return !m_live.empty() && *m_live.rbegin() >= offset;
+}
+
+void
+LArena::rewind (std::size_t offset)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (inUseAbove(offset)) {
+        amrex::Abort("LArena: memory still in use when recycling the buffer");
+    }
+    m_offset = std::min(m_offset, offset);
+}
+
+void
+LArena::PrintUsage (std::string const& name) const
+{
+    Long min_megabytes = static_cast<Long>(highWaterMark() / (1024*1024));
+    Long max_megabytes = min_megabytes;
+    Long min_fallbacks = static_cast<Long>(numFallbacks());
+    Long max_fallbacks = min_fallbacks;
+    const int IOProc = ParallelDescriptor::IOProcessorNumber();
+    ParallelReduce::Min<Long>({min_megabytes, min_fallbacks},
+                              IOProc, ParallelDescriptor::Communicator());
+    ParallelReduce::Max<Long>({max_megabytes, max_fallbacks},
+                              IOProc, ParallelDescriptor::Communicator());
+#ifdef AMREX_USE_MPI
+    amrex::Print() << "[" << name << "]" << " capacity (MB): " << capacity()/(1024*1024) << "\n"
+                   << "[" << name << "]" << " high water mark (MB) spread across MPI: ["
+                   << min_megabytes << " ... " << max_megabytes << "]\n"
+                   << "[" << name << "]" << " # of fallbacks       spread across MPI: ["
+                   << min_fallbacks << " ... " << max_fallbacks << "]\n";
+#else
+    amrex::Print() << "[" << name << "]" << " capacity (MB): " << capacity()/(1024*1024) << "\n";
+    amrex::Print() << "[" << name << "]" << " high water mark (MB): " << min_megabytes << "\n";
+    amrex::Print() << "[" << name << "]" << " # of fallbacks      : " << min_fallbacks << "\n";
+#endif
+}
+
+LArena::Scope::Scope (Arena* arena) noexcept
+    : m_arena(dynamic_cast<LArena*>(arena)),
+      m_offset(0)
+{
+    if (m_arena) {
+        std::lock_guard<std::mutex> lock(m_arena->m_mutex);
+        m_offset = m_arena->m_offset;
+    }
+}
+
+LArena::Scope::~Scope ()
+{
+    if (m_arena) {
+        m_arena->rewind(m_offset);
+    }
+}
+
+bool
+LArena::Scope::canRecycle () const
+{
+    if (m_arena) {
+        std::lock_guard<std::mutex> lock(m_arena->m_mutex);
+        return !m_arena->inUseAbove(m_offset);
+    }
+    return true;
+}
+
+}
@@ -3,11 +3,125 @@
 #include <AMReX_FabArray.H>
 #include <AMReX_FArrayBox.H>
 #include <AMReX_OpenMP.H>
+#include <AMReX_BoxCosts.H>
+#include <AMReX_Utility.H>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
 
 namespace amrex {
 
 int MFIter::nextDynamicIndex = std::numeric_limits<int>::min();
 int MFIter::depth = 0;
+Vector<MFIter::ThreadStats> MFIter::thread_stats;
+
+namespace {
+    //
+    // Wall clock time this thread has spent in the MFIter loops that
+    // measure BoxCosts.  A loop nested in such a loop adds its time here,
+    // and the tile of the outer loop is charged without it.
+    //
+    double cost_loop_time = 0.;
+}
+#ifdef _OPENMP
+#pragma omp threadprivate(cost_loop_time)
+#endif
+
+#ifdef _OPENMP
+namespace {
+
+    //
+    // The tile range [lo,hi) of each thread for work stealing, packed into
+    // one word so that the owner and the thieves can update it with
+    // compare-and-swap.  A tile leaves the ranges for good when a thread
+    // takes it, so the same packed value cannot come back.
+    //
+    struct StealRange
+    {
+        std::atomic<std::uint64_t> r{0};
+        char pad[64-sizeof(std::atomic<std::uint64_t>)]; // one cache line per thread
+    };
+
+    std::unique_ptr<StealRange[]> steal_ranges;
+    int steal_nranges = 0;
+
+    std::uint64_t steal_pack (int lo, int hi) noexcept
+    {
+        return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(lo)) << 32)
+            | static_cast<std::uint32_t>(hi);
+    }
+
+    int steal_lo (std::uint64_t v) noexcept { return static_cast<int>(v >> 32); }
+    int steal_hi (std::uint64_t v) noexcept { return static_cast<int>(v & 0xffffffffu); }
+
+    void steal_alloc (int nthreads)
+    {
+        if (nthreads > steal_nranges) {
+            steal_ranges.reset(new StealRange[nthreads]);
+            steal_nranges = nthreads;
+        }
+    }
+
+    //! The next tile of thread tid, or end if there are none left anywhere
+    int steal_next (int tid, int nthreads, int end, bool& stolen) noexcept
+    {
+        stolen = false;
+
+        std::atomic<std::uint64_t>& mine = steal_ranges[tid].r;
+        std::uint64_t v = mine.load();
+        while (steal_lo(v) < steal_hi(v)) {
+            if (mine.compare_exchange_weak(v, steal_pack(steal_lo(v)+1, steal_hi(v)))) {
+                return steal_lo(v);
+            }
+        }
+
+        while (true)
+        {
+            int victim = -1;
+            int most = 0;
+            std::uint64_t vv = 0;
+            for (int i = 0; i < nthreads; ++i) {
+                const std::uint64_t w = steal_ranges[i].r.load();
+                if (steal_hi(w) - steal_lo(w) > most) {
+                    most = steal_hi(w) - steal_lo(w);
+                    victim = i;
+                    vv = w;
+                }
+            }
+            if (victim < 0) return end;
+
+            const int lo = steal_lo(vv);
+            const int hi = steal_hi(vv);
+            const int mid = lo + (hi-lo)/2;
+            if (steal_ranges[victim].r.compare_exchange_strong(vv, steal_pack(lo,mid))) {
+                // Nobody steals from an empty range, so a plain store is fine.
+                mine.store(steal_pack(mid+1,hi));
+                stolen = true;
+                return mid;
+            }
+        }
+    }
+}
+#endif
+
+void
+MFIter::ResetThreadStatistics ()
+{
+    thread_stats.clear();
+    thread_stats.resize(OpenMP::get_max_threads());
+}
+
+Real
+MFIter::ThreadImbalance () noexcept
+{
+    double tmax = 0., tsum = 0.;
+    for (auto const& st : thread_stats) {
+        tmax = std::max(tmax, st.time);
+        tsum += st.time;
+    }
+    return (tsum > 0.) ? static_cast<Real>(tmax*thread_stats.size()/tsum) : Real(1.);
+}
 
 MFIter::MFIter (const FabArrayBase& fabarray_, 
 		unsigned char       flags_)
@@ -147,6 +261,7 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm, const MFItInf
     flags(info.do_tiling ? Tiling : 0),
     streams(info.num_streams),
     dynamic(info.dynamic && (OpenMP::get_num_threads() > 1)),
+    work_stealing(dynamic && info.work_stealing),
     device_sync(info.device_sync),
     index_map(nullptr),
     local_index_map(nullptr),
@@ -164,7 +279,10 @@ MFIter::MFIter (const BoxArray& ba, const DistributionMapping& dm, const MFItInf
     if (dynamic) {
 #pragma omp barrier
 #pragma omp single
-        nextDynamicIndex = omp_get_num_threads();
+        {
+            nextDynamicIndex = omp_get_num_threads();
+            if (work_stealing) steal_alloc(omp_get_num_threads());
+        }
         // yes omp single has an implicit barrier and we need it because nextDynamicIndex is static.
     }
 #endif
@@ -179,6 +297,7 @@ MFIter::MFIter (const FabArrayBase& fabarray_, const MFItInfo& info)
     flags(info.do_tiling ? Tiling : 0),
     streams(info.num_streams),
     dynamic(info.dynamic && (OpenMP::get_num_threads() > 1)),
+    work_stealing(dynamic && info.work_stealing),
     device_sync(info.device_sync),
     index_map(nullptr),
     local_index_map(nullptr),
@@ -190,7 +309,10 @@ MFIter::MFIter (const FabArrayBase& fabarray_, const MFItInfo& info)
     if (dynamic) {
 #pragma omp barrier
 #pragma omp single
-        nextDynamicIndex = omp_get_num_threads();
+        {
+            nextDynamicIndex = omp_get_num_threads();
+            if (work_stealing) steal_alloc(omp_get_num_threads());
+        }
         // yes omp single has an implicit barrier and we need it because nextDynamicIndex is static.
     }
 #endif
@@ -208,6 +330,10 @@ MFIter::~MFIter ()
         depth = 0;
     }
 
+    if (m_costs) {
+        cost_loop_time = m_cost_loop_nested + (amrex::second() - m_cost_loop_time);
+    }
+
 #ifdef BL_USE_TEAM
     if ( ! (flags & NoTeamBarrier) )
 	ParallelDescriptor::MyTeam().MemoryBarrier();
@@ -320,7 +446,7 @@ MFIter::Initialize ()
 	int nthreads = omp_get_num_threads();
 	if (nthreads > 1)
 	{
-            if (dynamic)
+            if (dynamic && !work_stealing)
             {
                 beginIndex = omp_get_thread_num();
             }
@@ -343,6 +469,18 @@ MFIter::Initialize ()
 
 	currentIndex = beginIndex;
 
+        bool stolen = false;
+#ifdef _OPENMP
+        if (work_stealing)
+        {
+            const int tid = omp_get_thread_num();
+            steal_ranges[tid].r.store(steal_pack(beginIndex, endIndex));
+            endIndex = index_map->size();
+#pragma omp barrier
+            currentIndex = steal_next(tid, nthreads, endIndex, stolen);
+        }
+#endif
+
 #ifdef AMREX_USE_GPU
 	Gpu::Device::setStreamIndex((streams > 0) ? currentIndex%streams : -1);
         Gpu::resetNumCallbacks();
@@ -354,6 +492,19 @@ MFIter::Initialize ()
 #endif
 
 	typ = fabArray.boxArray().ixType();
+
+        m_costs = BoxCosts::find(fabArray);
+        if (m_costs) {
+            m_cost_time = m_cost_loop_time = amrex::second();
+            m_cost_nested = m_cost_loop_nested = cost_loop_time;
+        }
+
+        m_stats = FabArrayBase::mfiter_thread_stats
+            && OpenMP::get_thread_num() < static_cast<int>(thread_stats.size());
+        if (m_stats) {
+            m_stats_time = amrex::second();
+            if (stolen) ++thread_stats[OpenMP::get_thread_num()].nsteals;
+        }
     }
 }
 
@@ -497,8 +648,21 @@ MFIter::grownnodaltilebox (int dir, IntVect const& a_ng) const noexcept
 void
 MFIter::operator++ () noexcept
 {
+    if (m_costs) {
+        const double t = amrex::second();
+        m_costs->add(*this, (t - m_cost_time) - (cost_loop_time - m_cost_nested));
+        m_cost_time = t;
+        m_cost_nested = cost_loop_time;
+    }
+
+    bool stolen = false;
+
 #ifdef _OPENMP
-    if (dynamic)
+    if (work_stealing)
+    {
+        currentIndex = steal_next(omp_get_thread_num(), omp_get_num_threads(), endIndex, stolen);
+    }
+    else if (dynamic)
     {
 #pragma omp atomic capture
         currentIndex = nextDynamicIndex++;
@@ -530,6 +694,13 @@ MFIter::operator++ () noexcept
         }
 #endif
     }
+
+    if (m_stats) {
+        ThreadStats& st = thread_stats[OpenMP::get_thread_num()];
+        ++st.ntiles;
+        if (stolen) ++st.nsteals;
+        if (!isValid()) st.time += amrex::second() - m_stats_time;
+    }
 }
 
 #ifdef AMREX_USE_GPU_PRAGMA
@@ -0,0 +1,428 @@
+#include <AMReX_MFTaskGraph.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParallelContext.H>
+#include <AMReX_ParallelReduce.H>
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <thread>
+
+namespace amrex {
+
+Box
+MFTaskGraph::Tile::growntilebox (const IntVect& ng) const noexcept
+{
+    Box bx = m_tilebox;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        if (bx.smallEnd(d) == m_validbox.smallEnd(d)) {
+            bx.growLo(d, ng[d]);
+        }
+        if (bx.bigEnd(d) == m_validbox.bigEnd(d)) {
+            bx.growHi(d, ng[d]);
+        }
+    }
+    return bx;
+}
+
+MFTaskGraph::MFTaskGraph (const MFItInfo& info)
+    : m_info(info)
+{}
+
+Long
+MFTaskGraph::numEdges () const noexcept
+{
+    Long n = 0;
+    for (auto const& nd : m_nodes) {
+        n += nd.succ.size();
+    }
+    return n;
+}
+
+int
+MFTaskGraph::addNode (Kind kind, std::function<void()> f, Vector<int>& deps)
+{
+    const int id = m_nodes.size();
+    m_nodes.emplace_back();
+    Node& nd = m_nodes.back();
+    nd.kind = kind;
+    nd.run = std::move(f);
+
+    std::sort(deps.begin(), deps.end());
+    deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+    for (int d : deps) {
+        if (d >= 0) {
+            m_nodes[d].succ.push_back(id);
+            ++nd.ndeps;
+        }
+    }
+    return id;
+}
+
+MFTaskGraph::FAState&
+MFTaskGraph::state (const FabArrayBase& fa)
+{
+    auto it = m_state.find(&fa);
+    if (it == m_state.end()) {
+        FAState& st = m_state[&fa];
+        const int nlocal = fa.local_size();
+        st.writers.resize(nlocal);
+        st.readers.resize(nlocal);
+        st.fb_ready.resize(nlocal, -1);
+        st.filled = IntVect(0);
+        return st;
+    }
+    return it->second;
+}
+
+Vector<MFTaskGraph::Tile>
+MFTaskGraph::makeTiles (const Access& a) const
+{
+    Vector<Tile> tiles;
+    for (MFIter mfi(*a.fa, m_info); mfi.isValid(); ++mfi) {
+        tiles.emplace_back(mfi.index(), mfi.LocalIndex(), mfi.tilebox(), mfi.validbox());
+    }
+    return tiles;
+}
+
+void
+MFTaskGraph::insertFillBoundary (const Access& a, FAState& st, const IntVect& ng)
+{
+    //
+    // The FillBoundary reads the valid cells of all the FABs and writes
+    // their ghost cells.
+    //
+    Vector<int> deps = st.ghost_readers;
+    for (auto const& w : st.writers) {
+        deps.insert(deps.end(), w.begin(), w.end());
+    }
+    deps.push_back(st.fb_finish);
+
+    const int fb = m_fbs.size();
+    auto start = a.fb_start;
+    const Periodicity period = a.period;
+    const int istart = addNode(Kind::comm, [=] () { start(ng, period); }, deps);
+    m_nodes[istart].ordered = true;
+    m_ordered.push_back(istart);
+
+    // The ghost cells of each FAB are ready when its messages have arrived.
+    Vector<int> finish_deps{istart};
+    for (int li = 0, N = st.fb_ready.size(); li < N; ++li) {
+        Vector<int> d{istart};
+        const int ipoll = addNode(Kind::poll, std::function<void()>(), d);
+        auto isready = a.fb_isready;
+        m_nodes[ipoll].ready = [=] () { return isready(li); };
+        m_nodes[ipoll].fb = fb;
+        st.fb_ready[li] = ipoll;
+        finish_deps.push_back(ipoll);
+    }
+
+    const int ifinish = addNode(Kind::comm, a.fb_finish, finish_deps);
+
+    m_fbs.push_back(FBInfo{a.fb_testsome, istart, ifinish});
+    ++m_nfb;
+
+    st.fb_finish = ifinish;
+    st.filled = ng;
+    st.period = a.period;
+    st.ghost_readers.clear();
+}
+
+void
+MFTaskGraph::addAccess (const Vector<Access>& access, const Vector<Tile>& tiles,
+                        Vector<Vector<int> >& deps)
+{
+    const FabArrayBase& fa0 = *access[0].fa;
+    for (auto const& a : access)
+    {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(a.fa->size() == fa0.size() &&
+                                         a.fa->DistributionMap() == fa0.DistributionMap(),
+                                         "MFTaskGraph: FabArrays with different layouts");
+        FAState& st = state(*a.fa);
+
+        const bool writes = a.intent != Intent::in;
+        const bool ghosts = a.intent != Intent::out && a.nghost.max() > 0;
+
+        if (ghosts && (!a.nghost.allLE(st.filled) || !(a.period == st.period))) {
+            insertFillBoundary(a, st, a.nghost);
+        }
+
+        for (int t = 0, N = tiles.size(); t < N; ++t)
+        {
+            const int li = tiles[t].LocalIndex();
+            Vector<int>& d = deps[t];
+            d.insert(d.end(), st.writers[li].begin(), st.writers[li].end());
+            if (ghosts) {
+                d.push_back(st.fb_ready[li]);
+            }
+            if (writes) {
+                d.insert(d.end(), st.readers[li].begin(), st.readers[li].end());
+                d.push_back(st.fb_finish);
+            }
+        }
+    }
+}
+
+void
+MFTaskGraph::recordAccess (const Vector<Access>& access, const Vector<Tile>& tiles,
+                           const Vector<int>& task)
+{
+    for (auto const& a : access)
+    {
+        FAState& st = state(*a.fa);
+        if (a.intent == Intent::in)
+        {
+            const bool ghosts = a.nghost.max() > 0;
+            for (int t = 0, N = tiles.size(); t < N; ++t) {
+                st.readers[tiles[t].LocalIndex()].push_back(task[t]);
+                if (ghosts) st.ghost_readers.push_back(task[t]);
+            }
+        }
+        else
+        {
+            for (auto const& tile : tiles) {
+                st.writers[tile.LocalIndex()].clear();
+                st.readers[tile.LocalIndex()].clear();
+            }
+            for (int t = 0, N = tiles.size(); t < N; ++t) {
+                st.writers[tiles[t].LocalIndex()].push_back(task[t]);
+            }
+            st.filled = IntVect(0);
+        }
+    }
+}
+
+void
+MFTaskGraph::addLoop (const Vector<Access>& access, std::function<void(Tile const&)> f)
+{
+    AMREX_ALWAYS_ASSERT(!access.empty());
+
+    const Vector<Tile> tiles = makeTiles(access[0]);
+    Vector<Vector<int> > deps(tiles.size());
+    addAccess(access, tiles, deps);
+
+    auto fp = std::make_shared<std::function<void(Tile const&)> >(std::move(f));
+    Vector<int> task(tiles.size());
+    for (int t = 0, N = tiles.size(); t < N; ++t) {
+        const Tile& tile = tiles[t];
+        task[t] = addNode(Kind::compute, [fp,tile] () { (*fp)(tile); }, deps[t]);
+    }
+
+    recordAccess(access, tiles, task);
+}
+
+void
+MFTaskGraph::addReduction (const Vector<Access>& access, ReduceType type,
+                           std::function<Real(Tile const&)> f, Real& result, bool local)
+{
+    AMREX_ALWAYS_ASSERT(!access.empty());
+    for (auto const& a : access) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(a.intent == Intent::in,
+                                         "MFTaskGraph::addReduction: FabArrays must be read-only");
+    }
+
+    const Vector<Tile> tiles = makeTiles(access[0]);
+    Vector<Vector<int> > deps(tiles.size());
+    addAccess(access, tiles, deps);
+
+    auto fp = std::make_shared<std::function<Real(Tile const&)> >(std::move(f));
+    auto partial = std::make_shared<Vector<Real> >(tiles.size());
+    Vector<int> task(tiles.size());
+    for (int t = 0, N = tiles.size(); t < N; ++t) {
+        const Tile& tile = tiles[t];
+        task[t] = addNode(Kind::compute, [fp,partial,t,tile] () { (*partial)[t] = (*fp)(tile); },
+                          deps[t]);
+    }
+
+    recordAccess(access, tiles, task);
+
+    // Combine the tiles in a fixed order, so that the result does not
+    // depend on the order the tasks ran in.
+    Real* r = &result;
+    Vector<int> tasks = task;
+    const int icombine = addNode(local ? Kind::compute : Kind::comm, [=] () {
+        Real v = (type == ReduceType::sum) ? Real(0.)
+            : ((type == ReduceType::min) ?  std::numeric_limits<Real>::max()
+                                         : std::numeric_limits<Real>::lowest());
+        for (Real p : *partial) {
+            if (type == ReduceType::sum) {
+                v += p;
+            } else if (type == ReduceType::min) {
+                v = std::min(v, p);
+            } else {
+                v = std::max(v, p);
+            }
+        }
+        if (!local) {
+            if (type == ReduceType::sum) {
+                ParallelAllReduce::Sum(v, ParallelContext::CommunicatorSub());
+            } else if (type == ReduceType::min) {
+                ParallelAllReduce::Min(v, ParallelContext::CommunicatorSub());
+            } else {
+                ParallelAllReduce::Max(v, ParallelContext::CommunicatorSub());
+            }
+        }
+        *r = v;
+    }, tasks);
+
+    if (!local) {
+        m_nodes[icombine].ordered = true;
+        m_ordered.push_back(icombine);
+    }
+}
+
+void
+MFTaskGraph::execute ()
+{
+    BL_PROFILE("MFTaskGraph::execute()");
+
+    const int N = m_nodes.size();
+
+    if (Gpu::inLaunchRegion() || OpenMP::in_parallel())
+    {
+        // The order the nodes were added in is a valid order.  The
+        // FillBoundary calls block here, so the poll nodes are ready.
+        for (auto& nd : m_nodes) {
+            if (nd.kind != Kind::poll) {
+                nd.run();
+            } else {
+                while (!nd.ready()) {
+                    m_fbs[nd.fb].testsome(true);
+                }
+            }
+        }
+    }
+    else if (N > 0)
+    {
+        std::unique_ptr<std::atomic<int>[]> ndeps(new std::atomic<int>[N]);
+        std::deque<int> compute_q;
+        std::deque<int> comm_q;   // unordered communication on the master thread
+        Vector<int> gated;        // poll nodes whose dependencies are done
+        Vector<char> fb_active(m_fbs.size(), 0);
+        std::atomic<int> ndone{0};
+        int next_ordered = 0;     // only touched by the master thread
+
+        auto push = [&] (int i) {
+            const Node& nd = m_nodes[i];
+            if (nd.ordered) return; // The master thread runs these in order.
+#ifdef _OPENMP
+#pragma omp critical (amrex_mftaskgraph)
+#endif
+            {
+                if (nd.kind == Kind::compute) {
+                    compute_q.push_back(i);
+                } else if (nd.kind == Kind::comm) {
+                    comm_q.push_back(i);
+                } else {
+                    gated.push_back(i);
+                }
+            }
+        };
+
+        auto complete = [&] (int i) {
+            for (int s : m_nodes[i].succ) {
+                if (--ndeps[s] == 0) push(s);
+            }
+            ++ndone;
+        };
+
+        for (int i = 0; i < N; ++i) {
+            ndeps[i] = m_nodes[i].ndeps;
+        }
+        for (int i = 0; i < N; ++i) {
+            if (m_nodes[i].ndeps == 0) push(i);
+        }
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            const bool master = OpenMP::get_thread_num() == 0;
+            while (ndone < N)
+            {
+                int i = -1;
+                if (master)
+                {
+                    const int nordered = m_ordered.size();
+                    if (next_ordered < nordered && ndeps[m_ordered[next_ordered]] == 0) {
+                        i = m_ordered[next_ordered++];
+                        const Node& nd = m_nodes[i];
+                        if (nd.kind == Kind::comm) {
+                            for (int fb = 0, nfb = m_fbs.size(); fb < nfb; ++fb) {
+                                if (m_fbs[fb].start == i) fb_active[fb] = 1;
+                            }
+                        }
+                    }
+
+                    if (i < 0) {
+#ifdef _OPENMP
+#pragma omp critical (amrex_mftaskgraph)
+#endif
+                        if (!comm_q.empty()) {
+                            i = comm_q.front();
+                            comm_q.pop_front();
+                        }
+                        if (i >= 0) {
+                            for (int fb = 0, nfb = m_fbs.size(); fb < nfb; ++fb) {
+                                if (m_fbs[fb].finish == i) fb_active[fb] = 0;
+                            }
+                        }
+                    }
+
+                    if (i < 0)
+                    {
+                        // Make progress on the messages, and release the
+                        // FABs whose ghost cells have arrived.
+                        for (int fb = 0, nfb = m_fbs.size(); fb < nfb; ++fb) {
+                            if (fb_active[fb]) m_fbs[fb].testsome(false);
+                        }
+                        Vector<int> released;
+#ifdef _OPENMP
+#pragma omp critical (amrex_mftaskgraph)
+#endif
+                        {
+                            for (int j = 0; j < static_cast<int>(gated.size()); ) {
+                                if (m_nodes[gated[j]].ready()) {
+                                    released.push_back(gated[j]);
+                                    gated[j] = gated.back();
+                                    gated.pop_back();
+                                } else {
+                                    ++j;
+                                }
+                            }
+                        }
+                        for (int j : released) {
+                            complete(j);
+                        }
+                    }
+                }
+
+                if (i < 0) {
+#ifdef _OPENMP
+#pragma omp critical (amrex_mftaskgraph)
+#endif
+                    if (!compute_q.empty()) {
+                        i = compute_q.front();
+                        compute_q.pop_front();
+                    }
+                }
+
+                if (i >= 0) {
+                    m_nodes[i].run();
+                    complete(i);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    m_nodes.clear();
+    m_fbs.clear();
+    m_state.clear();
+    m_ordered.clear();
+}
+
+}
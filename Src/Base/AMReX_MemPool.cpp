@@ -5,6 +5,7 @@
 #include <memory>
 #include <cstring>
 #include <cstdint>
+#include <array>
 
 #include <AMReX_CArena.H>
 #include <AMReX_MemPool.H>
@@ -28,6 +29,78 @@ namespace
     static int init_snan = 0;
 #endif
     static bool initialized = false;
+
+    //
+    // Per-thread cache in front of the thread's CArena.  Requests are
+    // rounded up to size classes (four per power of two) so that a freed
+    // block can be handed out again without going through the arena.
+    // Each magazine holds blocks of one class.  When a magazine is full,
+    // half of it is returned to the arena in one batch.
+    //
+    // Every block carries a small header in front of the returned pointer
+    // recording its size class and the thread whose arena owns it, so
+    // that free does not need any lookup.
+    //
+    static bool use_cache = true;
+    static int magazine_size = 16;
+
+    constexpr int cache_min_log2 = 8;   // 256 B
+    constexpr int cache_max_log2 = 24;  // 16 MB
+    constexpr int cache_num_classes = (cache_max_log2-cache_min_log2)*4 + 1;
+
+    struct BlockHeader
+    {
+        int size_class; // -1 if not cacheable
+        int owner;      // thread id of the owning arena
+    };
+    constexpr std::size_t header_size = Arena::align_size;
+    static_assert(sizeof(BlockHeader) <= header_size, "MemPool: BlockHeader too big");
+
+    struct MemPoolCache
+    {
+        std::array<Vector<void*>,cache_num_classes> magazines;
+        Long hits = 0;
+        Long misses = 0;
+    };
+
+    static Vector<std::unique_ptr<MemPoolCache> > the_caches;
+
+    // Return the size class of nbytes, or -1 if it is too large to be cached.
+    int cache_class (std::size_t nbytes) noexcept
+    {
+        if (nbytes <= (std::size_t(1) << cache_min_log2)) return 0;
+        if (nbytes >  (std::size_t(1) << cache_max_log2)) return -1;
+        int b = 0;
+        std::size_t n = nbytes-1;
+        while (n >>= 1) { ++b; }
+        // 2^b < nbytes <= 2^(b+1)
+        const std::size_t step = std::size_t(1) << (b-2);
+        const int sub = static_cast<int>((nbytes - (std::size_t(1) << b) + step - 1) / step);
+        return (b-cache_min_log2)*4 + sub;
+    }
+
+    std::size_t cache_class_size (int c) noexcept
+    {
+        if (c == 0) return std::size_t(1) << cache_min_log2;
+        const int b = (c-1)/4 + cache_min_log2;
+        const int sub = (c-1)%4 + 1;
+        return (std::size_t(1) << b) + sub * (std::size_t(1) << (b-2));
+    }
+
+    BlockHeader* block_header (void* p) noexcept
+    {
+        return reinterpret_cast<BlockHeader*>(static_cast<char*>(p) - header_size);
+    }
+
+    void cache_flush (MemPoolCache& cache, CArena& arena)
+    {
+        for (auto& mag : cache.magazines) {
+            for (void* p : mag) {
+                arena.free(block_header(p));
+            }
+            mag.clear();
+        }
+    }
 }
 
 extern "C" {
@@ -40,11 +113,16 @@ void amrex_mempool_init ()
 
         ParmParse pp("fab");
 	pp.query("init_snan", init_snan);
+	pp.query("mempool_cache", use_cache);
+	pp.query("mempool_magazine_size", magazine_size);
+	if (magazine_size < 2) use_cache = false;
 
 	int nthreads = OpenMP::get_max_threads();
 
 	the_memory_pool.resize(nthreads);
+	the_caches.resize(nthreads);
 	for (int i=0; i<nthreads; ++i) {
+            the_caches[i].reset(new MemPoolCache);
 // xxxxx HIP FIX THIS - Default Arena w/o managed?
 // Default arena is currently Device on HIP where there is no managed option.
 // Need to adjust to CPU specifically in that case.
@@ -80,19 +158,70 @@ void amrex_mempool_init ()
 void amrex_mempool_finalize ()
 {
     initialized = false;
+    for (int i = 0, N = the_caches.size(); i < N; ++i) {
+        cache_flush(*the_caches[i], *the_memory_pool[i]);
+    }
+    the_caches.clear();
     the_memory_pool.clear();
 }
 
 void* amrex_mempool_alloc (size_t nbytes)
 {
   int tid = OpenMP::get_thread_num();
-  return the_memory_pool[tid]->alloc(nbytes);
+  if (!use_cache) {
+      return the_memory_pool[tid]->alloc(nbytes);
+  }
+
+  const int c = cache_class(nbytes);
+  void* p;
+  if (c < 0) {
+      p = the_memory_pool[tid]->alloc(nbytes + header_size);
+  } else {
+      MemPoolCache& cache = *the_caches[tid];
+      auto& mag = cache.magazines[c];
+      if (mag.empty()) {
+          ++cache.misses;
+          p = the_memory_pool[tid]->alloc(cache_class_size(c) + header_size);
+      } else {
+          ++cache.hits;
+          p = block_header(mag.back());
+          mag.pop_back();
+      }
+  }
+  BlockHeader* h = static_cast<BlockHeader*>(p);
+  h->size_class = c;
+  h->owner = tid;
+  return static_cast<char*>(p) + header_size;
 }
 
 void amrex_mempool_free (void* p) 
 {
   int tid = OpenMP::get_thread_num();
-  the_memory_pool[tid]->free(p);
+  if (!use_cache) {
+      the_memory_pool[tid]->free(p);
+      return;
+  }
+
+  if (p == nullptr) return;
+
+  BlockHeader* h = block_header(p);
+  if (h->size_class < 0 || h->owner != tid) {
+      // CArena is thread safe, so a block freed by another thread can go
+      // straight back to its owner.
+      the_memory_pool[h->owner]->free(h);
+      return;
+  }
+
+  auto& mag = the_caches[tid]->magazines[h->size_class];
+  if (static_cast<int>(mag.size()) >= magazine_size) {
+      // Return the older half of the magazine to the arena.
+      const int nreturn = magazine_size/2;
+      for (int i = 0; i < nreturn; ++i) {
+          the_memory_pool[tid]->free(block_header(mag[i]));
+      }
+      mag.erase(mag.begin(), mag.begin()+nreturn);
+  }
+  mag.push_back(p);
 }
 
 void amrex_mempool_get_stats (int& mp_min, int& mp_max, int& mp_tot) // min, max & tot in MB
@@ -111,6 +240,16 @@ void amrex_mempool_get_stats (int& mp_min, int& mp_max, int& mp_tot) // min, max
   mp_tot = hsu_tot/(1024*1024);
 }
 
+void amrex_mempool_get_cache_stats (Long& hits, Long& misses)
+{
+  hits = 0;
+  misses = 0;
+  for (const auto& cache : the_caches) {
+    hits += cache->hits;
+    misses += cache->misses;
+  }
+}
+
 void amrex_real_array_init (Real* p, size_t nelems)
 {
     if (init_snan) amrex_array_init_snan(p, nelems);
@@ -12,6 +12,7 @@
 #include <AMReX_BLProfiler.H>
 #include <AMReX_iMultiFab.H>
 #include <AMReX_FabArrayUtility.H>
+#include <AMReX_ReproducibleSum.H>
 
 #ifdef AMREX_MEM_PROFILING
 #include <AMReX_MemProfiler.H>
@@ -30,6 +31,71 @@ namespace
     int num_multifabs     = 0;
     int num_multifabs_hwm = 0;
 #endif
+
+    //! Are the sums exact?  Only on the CPU.
+    bool reproducible_sums ()
+    {
+        return ParallelDescriptor::UseReproducibleSums() && Gpu::notInLaunchRegion();
+    }
+
+    /**
+    * \brief The exact local sum of the terms added by f(mfi, box, s) to
+    * s for the tiles of mf grown by nghost.  The threads accumulate
+    * separately and their sums are combined exactly.
+    */
+    template <typename F>
+    ReproducibleSum repro_sum (const FabArrayBase& mf, int nghost, F const& f)
+    {
+        ReproducibleSum r;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+        {
+            ReproducibleSum t;
+            for (MFIter mfi(mf,true); mfi.isValid(); ++mfi) {
+                f(mfi, mfi.growntilebox(nghost), t);
+            }
+#ifdef _OPENMP
+#pragma omp critical (multifab_repro_sum)
+#endif
+            r += t;
+        }
+        return r;
+    }
+
+    ReproducibleSum repro_dot (const MultiFab& x, int xcomp, const MultiFab& y, int ycomp,
+                               int numcomp, int nghost)
+    {
+        return repro_sum(x, nghost,
+        [&] (MFIter const& mfi, Box const& bx, ReproducibleSum& t)
+        {
+            Array4<Real const> const& xfab = x.const_array(mfi);
+            Array4<Real const> const& yfab = y.const_array(mfi);
+            AMREX_LOOP_4D(bx, numcomp, i, j, k, n,
+            {
+                t.add(xfab(i,j,k,xcomp+n) * yfab(i,j,k,ycomp+n));
+            });
+        });
+    }
+
+    ReproducibleSum repro_norm1 (const MultiFab& x, int comp, int nghost)
+    {
+        return repro_sum(x, nghost,
+        [&] (MFIter const& mfi, Box const& bx, ReproducibleSum& t)
+        {
+            Array4<Real const> const& fab = x.const_array(mfi);
+            AMREX_LOOP_3D(bx, i, j, k,
+            {
+                t.add(amrex::Math::abs(fab(i,j,k,comp)));
+            });
+        });
+    }
+
+    Real repro_value (ReproducibleSum& s, bool local)
+    {
+        if (!local) s.ParallelSum(ParallelContext::CommunicatorSub());
+        return static_cast<Real>(s.value());
+    }
 }
 
 Real
@@ -43,6 +109,11 @@ MultiFab::Dot (const MultiFab& x, int xcomp,
 
     BL_PROFILE("MultiFab::Dot()");
 
+    if (reproducible_sums()) {
+        auto s = repro_dot(x, xcomp, y, ycomp, numcomp, nghost);
+        return repro_value(s, local);
+    }
+
     Real sm = 0.0;
 #ifdef AMREX_USE_GPU
     if (Gpu::inLaunchRegion()) {
@@ -84,6 +155,11 @@ MultiFab::Dot (const MultiFab& x, int xcomp, int numcomp, int nghost, bool local
 {
     BL_ASSERT(x.nGrow() >= nghost); 
 
+    if (reproducible_sums()) {
+        auto s = repro_dot(x, xcomp, x, xcomp, numcomp, nghost);
+        return repro_value(s, local);
+    }
+
     Real sm = amrex::ReduceSum(x, nghost,
     [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& xfab) -> Real
     {
@@ -115,6 +191,22 @@ MultiFab::Dot (const iMultiFab& mask,
     BL_ASSERT(x.nGrow() >= nghost and y.nGrow() >= nghost);
     BL_ASSERT(mask.nGrow() >= nghost);
 
+    if (reproducible_sums()) {
+        auto s = repro_sum(x, nghost,
+        [&] (MFIter const& mfi, Box const& bx, ReproducibleSum& t)
+        {
+            Array4<Real const> const& xfab = x.const_array(mfi);
+            Array4<Real const> const& yfab = y.const_array(mfi);
+            Array4<int const> const& mskfab = mask.const_array(mfi);
+            AMREX_LOOP_4D(bx, numcomp, i, j, k, n,
+            {
+                int mi = static_cast<int>(static_cast<bool>(mskfab(i,j,k)));
+                t.add(xfab(i,j,k,xcomp+n) * yfab(i,j,k,ycomp+n) * mi);
+            });
+        });
+        return repro_value(s, local);
+    }
+
     Real sm = amrex::ReduceSum(x, y, mask, nghost,
     [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& xfab,
                                Array4<Real const> const& yfab,
@@ -135,6 +227,33 @@ MultiFab::Dot (const iMultiFab& mask,
     return sm;
 }
 
+ParallelDescriptor::Future<Real>
+MultiFab::IDot (const MultiFab& x, int xcomp,
+                const MultiFab& y, int ycomp,
+                int numcomp, int nghost)
+{
+    if (reproducible_sums()) {
+        // The exact sum is reduced with a blocking call.
+        Real sm = MultiFab::Dot(x, xcomp, y, ycomp, numcomp, nghost);
+        return ParallelDescriptor::Future<Real>(&sm, 1);
+    }
+
+    Real sm = MultiFab::Dot(x, xcomp, y, ycomp, numcomp, nghost, true);
+    return ParallelDescriptor::IReduceRealSum(sm, ParallelContext::CommunicatorSub());
+}
+
+ParallelDescriptor::Future<Real>
+MultiFab::IDot (const MultiFab& x, int xcomp, int numcomp, int nghost)
+{
+    if (reproducible_sums()) {
+        Real sm = MultiFab::Dot(x, xcomp, numcomp, nghost);
+        return ParallelDescriptor::Future<Real>(&sm, 1);
+    }
+
+    Real sm = MultiFab::Dot(x, xcomp, numcomp, nghost, true);
+    return ParallelDescriptor::IReduceRealSum(sm, ParallelContext::CommunicatorSub());
+}
+
 void
 MultiFab::Add (MultiFab& dst, const MultiFab& src,
                int srccomp, int dstcomp, int numcomp, int nghost)
@@ -976,6 +1095,21 @@ MultiFab::norm2 (int comp, const Periodicity& period) const
 {
     auto mask = OverlapMask(period);
 
+    if (reproducible_sums()) {
+        auto s = repro_sum(*this, 0,
+        [&] (MFIter const& mfi, Box const& bx, ReproducibleSum& t)
+        {
+            Array4<Real const> const& xfab = this->const_array(mfi);
+            Array4<Real const> const& mfab = mask->const_array(mfi);
+            AMREX_LOOP_3D(bx, i, j, k,
+            {
+                Real tmp = xfab(i,j,k,comp);
+                t.add(tmp*tmp/mfab(i,j,k));
+            });
+        });
+        return std::sqrt(repro_value(s, false));
+    }
+
     Real nm2 = amrex::ReduceSum(*this, *mask, 0,
     [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& xfab,
                                Array4<Real const> const& mfab) -> Real
@@ -998,15 +1132,59 @@ MultiFab::norm2 (const Vector<int>& comps) const
 {
     BL_ASSERT(ixType().cellCentered());
 
-    int n = comps.size();
-    Vector<Real> nm2;
-    nm2.reserve(n);
+    return inorm2(comps).values();
+}
+
+ParallelDescriptor::Future<Real>
+MultiFab::inorm2 (int comp) const
+{
+    BL_ASSERT(ixType().cellCentered());
+
+    if (reproducible_sums()) {
+        Real nm2 = MultiFab::Dot(*this, comp, 1, 0);
+        ParallelDescriptor::Future<Real> r(&nm2, 1);
+        r.then([] (Real x) { return std::sqrt(x); });
+        return r;
+    }
+
+    Real nm2 = MultiFab::Dot(*this, comp, 1, 0, true);
+    auto r = ParallelDescriptor::IReduceRealSum(nm2, ParallelContext::CommunicatorSub());
+    r.then([] (Real x) { return std::sqrt(x); });
+    return r;
+}
 
+ParallelDescriptor::Future<Real>
+MultiFab::inorm2 (const Vector<int>& comps) const
+{
+    BL_ASSERT(ixType().cellCentered());
+
+    if (reproducible_sums()) {
+        Vector<ReproducibleSum> s;
+        s.reserve(comps.size());
+        for (int comp : comps) {
+            s.push_back(repro_dot(*this, comp, *this, comp, 1, 0));
+        }
+        ReproducibleSum::ParallelSum(s.data(), s.size(), ParallelContext::CommunicatorSub());
+        Vector<Real> nm2;
+        nm2.reserve(s.size());
+        for (auto const& x : s) {
+            nm2.push_back(static_cast<Real>(x.value()));
+        }
+        ParallelDescriptor::Future<Real> r(nm2.data(), nm2.size());
+        r.then([] (Real x) { return std::sqrt(x); });
+        return r;
+    }
+
+    Vector<Real> nm2;
+    nm2.reserve(comps.size());
     for (int comp : comps) {
-        nm2.push_back(this->norm2(comp));
+        nm2.push_back(MultiFab::Dot(*this, comp, 1, 0, true));
     }
 
-    return nm2;
+    auto r = ParallelDescriptor::IReduceRealSum(nm2.data(), nm2.size(),
+                                                ParallelContext::CommunicatorSub());
+    r.then([] (Real x) { return std::sqrt(x); });
+    return r;
 }
 
 Real
@@ -1033,6 +1211,11 @@ MultiFab::norm1 (int comp, const Periodicity& period, bool ignore_covered ) cons
 Real
 MultiFab::norm1 (int comp, int ngrow, bool local) const
 {
+    if (reproducible_sums()) {
+        auto s = repro_norm1(*this, comp, ngrow);
+        return repro_value(s, local);
+    }
+
     Real nm1 = amrex::ReduceSum(*this, ngrow,
     [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& fab) -> Real
     {
@@ -1059,6 +1242,21 @@ MultiFab::norm1 (const Vector<int>& comps, int ngrow, bool local) const
     Vector<Real> nm1;
     nm1.reserve(n);
 
+    if (reproducible_sums()) {
+        Vector<ReproducibleSum> s;
+        s.reserve(n);
+        for (int comp : comps) {
+            s.push_back(repro_norm1(*this, comp, ngrow));
+        }
+        if (!local) {
+            ReproducibleSum::ParallelSum(s.data(), n, ParallelContext::CommunicatorSub());
+        }
+        for (auto const& x : s) {
+            nm1.push_back(static_cast<Real>(x.value()));
+        }
+        return nm1;
+    }
+
     for (int comp : comps) {
         nm1.push_back(this->norm1(comp, ngrow, true));
     }
@@ -1072,6 +1270,19 @@ MultiFab::norm1 (const Vector<int>& comps, int ngrow, bool local) const
 Real
 MultiFab::sum (int comp, bool local) const
 {
+    if (reproducible_sums()) {
+        auto s = repro_sum(*this, 0,
+        [&] (MFIter const& mfi, Box const& bx, ReproducibleSum& t)
+        {
+            Array4<Real const> const& fab = this->const_array(mfi);
+            AMREX_LOOP_3D(bx, i, j, k,
+            {
+                t.add(fab(i,j,k,comp));
+            });
+        });
+        return repro_value(s, local);
+    }
+
     // 0 ghost cells
     Real sm = amrex::ReduceSum(*this, 0,
     [=] AMREX_GPU_HOST_DEVICE (Box const& bx, Array4<Real const> const& fab) -> Real
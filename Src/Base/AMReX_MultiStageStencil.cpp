@@ -0,0 +1,139 @@
+#include <AMReX_MultiStageStencil.H>
+#include <AMReX_FArrayBox.H>
+
+#include <algorithm>
+
+namespace amrex {
+
+void
+MultiStageStencil::addStage (const IntVect& radius, int ncomp, StageFunc f)
+{
+    AMREX_ALWAYS_ASSERT(radius.allGE(IntVect(0)) && ncomp > 0);
+    m_stages.push_back(Stage{radius, ncomp, std::move(f)});
+}
+
+IntVect
+MultiStageStencil::nGrow () const noexcept
+{
+    IntVect ng(0);
+    for (auto const& s : m_stages) {
+        ng += s.radius;
+    }
+    return ng;
+}
+
+Long
+MultiStageStencil::workingSet (const IntVect& ts, int ncomp_in) const
+{
+    // Stage s is computed on the tile grown by the radii of the stages
+    // after it, and reads the tile grown by its own radius too.
+    IntVect ng = nGrow();
+    Long bytes = amrex::grow(Box(IntVect(0), ts-1), ng).numPts() * ncomp_in;
+    for (auto const& s : m_stages) {
+        ng -= s.radius;
+        bytes += amrex::grow(Box(IntVect(0), ts-1), ng).numPts() * s.ncomp;
+    }
+    return bytes * static_cast<Long>(sizeof(Real));
+}
+
+IntVect
+MultiStageStencil::tileSize (const BoxArray& ba, int ncomp_in) const
+{
+    IntVect maxlen(1);
+    for (int i = 0, N = ba.size(); i < N; ++i) {
+        maxlen.max(ba[i].length());
+    }
+
+    //
+    // Keep the tiles long in the first direction for vectorization, and
+    // shrink the others until the working set fits in the cache.
+    //
+    IntVect ts = maxlen;
+    for (int t = 64; t >= 4; t /= 2) {
+        for (int d = 1; d < AMREX_SPACEDIM; ++d) {
+            ts[d] = std::min(t, maxlen[d]);
+        }
+        if (workingSet(ts, ncomp_in) <= m_cache_bytes) return ts;
+    }
+    while (ts[0] > 16 && workingSet(ts, ncomp_in) > m_cache_bytes) {
+        ts[0] /= 2;
+    }
+    return ts;
+}
+
+void
+MultiStageStencil::run (MultiFab& in, MultiFab& out, const Periodicity& period, int dcomp)
+{
+    in.FillBoundary(0, in.nComp(), nGrow(), period);
+    run(in, out, dcomp);
+}
+
+void
+MultiStageStencil::run (const MultiFab& in, MultiFab& out, int dcomp)
+{
+    BL_PROFILE("MultiStageStencil::run()");
+
+    const int nstages = m_stages.size();
+    if (nstages == 0) return;
+
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(in.nGrowVect().allGE(nGrow()),
+                                     "MultiStageStencil::run: not enough ghost cells");
+    AMREX_ALWAYS_ASSERT(dcomp + m_stages.back().ncomp <= out.nComp());
+    AMREX_ALWAYS_ASSERT_WITH_MESSAGE(out.boxArray() == in.boxArray() &&
+                                     out.DistributionMap() == in.DistributionMap(),
+                                     "MultiStageStencil::run: in and out must have the same grids");
+
+    // Cells around the tile that stage s computes
+    Vector<IntVect> grow(nstages);
+    {
+        IntVect ng = nGrow();
+        for (int s = 0; s < nstages; ++s) {
+            ng -= m_stages[s].radius;
+            grow[s] = ng;
+        }
+    }
+
+    MFItInfo info;
+    if (Gpu::notInLaunchRegion()) {
+        const IntVect ts = (m_tile_size.allGT(IntVect(0))) ? m_tile_size
+                                                           : tileSize(out.boxArray(), in.nComp());
+        info.EnableTiling(ts);
+    }
+
+    Long ncomputed = 0;
+    Long nwritten = 0;
+#ifdef _OPENMP
+#pragma omp parallel if (Gpu::notInLaunchRegion()) reduction(+:ncomputed,nwritten)
+#endif
+    {
+        // The buffers of this thread are reused for all its tiles.
+        Vector<FArrayBox> buf(nstages-1);
+        for (MFIter mfi(out, info); mfi.isValid(); ++mfi)
+        {
+            const Box& tbx = mfi.tilebox();
+            Array4<Real const> const& src = in.const_array(mfi);
+            Array4<Real const> prev = src;
+            for (int s = 0; s < nstages; ++s)
+            {
+                const Box bx = amrex::grow(tbx, grow[s]);
+                if (s < nstages-1) {
+                    buf[s].resize(bx, m_stages[s].ncomp);
+                    m_stages[s].f(bx, src, prev, buf[s].array());
+                    prev = buf[s].const_array();
+                } else {
+                    m_stages[s].f(bx, src, prev, out.array(mfi, dcomp));
+                }
+                ncomputed += bx.numPts();
+            }
+            nwritten += tbx.numPts();
+
+            // The buffers are reused by the next box.
+            if (Gpu::inLaunchRegion()) Gpu::streamSynchronize();
+        }
+    }
+
+    m_ncomputed = ncomputed;
+    m_nwritten = nwritten;
+}
+
+}
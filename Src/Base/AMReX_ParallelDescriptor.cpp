@@ -8,6 +8,8 @@
 #include <stack>
 #include <list>
 #include <chrono>
+#include <atomic>
+#include <algorithm>
 
 #include <AMReX.H>
 #include <AMReX_Utility.H>
@@ -17,6 +19,7 @@
 #include <AMReX_Print.H>
 #include <AMReX_TypeTraits.H>
 #include <AMReX_Arena.H>
+#include <AMReX_ReproducibleSum.H>
 
 #ifdef BL_USE_MPI
 #include <AMReX_ccse-mpi.H>
@@ -61,8 +64,18 @@ namespace amrex { namespace ParallelDescriptor {
     int use_gpu_aware_mpi = false;
 #endif
 
+    int use_reproducible_sums = false;
+
     ProcessTeam m_Team;
 
+    MPI_Comm m_node_comm = MPI_COMM_NULL;
+    Vector<int> m_rank_in_node;
+    Vector<int> m_node_of_rank;
+    int m_num_nodes = 1;
+#ifdef BL_USE_MPI
+    MPI_Info m_node_shm_info = MPI_INFO_NULL;
+#endif
+
     MPI_Comm m_comm = MPI_COMM_NULL;    // communicator for all ranks, probably MPI_COMM_WORLD
 
     int m_MinTag = 1000, m_MaxTag = -1;
@@ -254,6 +267,7 @@ Message::wait ()
 
     BL_COMM_PROFILE(BLProfiler::Wait, sizeof(m_type), pid(), tag());
     BL_MPI_REQUIRE( MPI_Wait(&m_req, &m_stat) );
+    m_finished = true;
     BL_COMM_PROFILE(BLProfiler::Wait, sizeof(m_type), BLProfiler::AfterCall(), tag());
 }
 
@@ -1011,6 +1025,11 @@ util::DoAllReduceReal (Real& r, MPI_Op op)
     Lazy::EvalReduction();
 #endif
 
+    if (op == MPI_SUM && UseReproducibleSums()) {
+        ReproducibleSum::ParallelSum(&r, 1, Communicator());
+        return;
+    }
+
     BL_PROFILE_S("ParallelDescriptor::util::DoAllReduceReal()");
     BL_COMM_PROFILE_ALLREDUCE(BLProfiler::AllReduceR, BLProfiler::BeforeCall(), true);
 
@@ -1049,6 +1068,11 @@ util::DoAllReduceReal (Real* r, MPI_Op op, int cnt)
     Lazy::EvalReduction();
 #endif
 
+    if (op == MPI_SUM && UseReproducibleSums()) {
+        ReproducibleSum::ParallelSum(r, cnt, Communicator());
+        return;
+    }
+
     BL_PROFILE_S("ParallelDescriptor::util::DoAllReduceReal()");
     BL_COMM_PROFILE_ALLREDUCE(BLProfiler::AllReduceR, BLProfiler::BeforeCall(), true);
 
@@ -1091,6 +1115,11 @@ util::DoReduceReal (Real& r, MPI_Op op, int cpu)
     Lazy::EvalReduction();
 #endif
 
+    if (op == MPI_SUM && UseReproducibleSums()) {
+        ReproducibleSum::ParallelSum(&r, 1, Communicator(), cpu);
+        return;
+    }
+
     BL_PROFILE_S("ParallelDescriptor::util::DoReduceReal()");
     BL_COMM_PROFILE_REDUCE(BLProfiler::ReduceR, sizeof(Real), cpu);
 
@@ -1135,6 +1164,11 @@ util::DoReduceReal (Real* r, MPI_Op op, int cnt, int cpu)
     Lazy::EvalReduction();
 #endif
 
+    if (op == MPI_SUM && UseReproducibleSums()) {
+        ReproducibleSum::ParallelSum(r, cnt, Communicator(), cpu);
+        return;
+    }
+
     BL_PROFILE_S("ParallelDescriptor::util::DoReduceReal()");
     BL_COMM_PROFILE_REDUCE(BLProfiler::ReduceR, cnt * sizeof(Real), cpu);
 
@@ -1891,6 +1925,97 @@ Waitsome (Vector<MPI_Request>& /*reqs*/, int& /*completed*/,
 
 #endif
 
+namespace {
+    //! The MPI_Iallreduce of a Future, with its buffers
+    template <typename T>
+    class IAllReduceRequest
+        : public Request
+    {
+    public:
+        IAllReduceRequest (const T* r, int cnt) : send(r, r+cnt), recv(r, r+cnt) {}
+        virtual ~IAllReduceRequest () override { msg.wait(); }
+        virtual bool test () override { return msg.test(); }
+        virtual void wait () override { msg.wait(); }
+
+        Vector<T> send;
+        Vector<T> recv;
+        Message   msg;
+    };
+}
+
+template <typename T>
+Future<T>::Future (const T* r, int cnt, MPI_Op op, MPI_Comm comm)
+    : m_state(std::make_shared<State>())
+{
+    m_state->value.assign(r, r+cnt);
+#ifdef BL_USE_MPI
+    BL_PROFILE_S("ParallelDescriptor::IReduce()");
+    if (std::is_floating_point<T>::value && op == MPI_SUM && UseReproducibleSums()) {
+        // The exact sum is reduced with a blocking call.
+        ReproducibleSum::ParallelSum(m_state->value.data(), cnt, comm);
+        return;
+    }
+    auto req = std::make_shared<IAllReduceRequest<T> >(r, cnt);
+    const MPI_Datatype type = Mpi_typemap<T>::type();
+#if (MPI_VERSION >= 3)
+    MPI_Request mpi_req;
+    BL_MPI_REQUIRE( MPI_Iallreduce(req->send.data(), req->recv.data(), cnt,
+                                   type, op, comm, &mpi_req) );
+    req->msg = Message(mpi_req, type);
+#else
+    BL_MPI_REQUIRE( MPI_Allreduce(req->send.data(), req->recv.data(), cnt,
+                                  type, op, comm) );
+#endif
+    IAllReduceRequest<T>* p = req.get();
+    m_state->req = std::move(req);
+    m_state->fetch = [p] (Vector<T>& v) { v = p->recv; };
+#else
+    amrex::ignore_unused(op, comm);
+#endif
+}
+
+template class Future<Real>;
+template class Future<int>;
+template class Future<Long>;
+
+namespace {
+    enum struct IReduceOp { sum, max, min };
+
+    template <typename T>
+    Future<T> IAllReduce (const T* r, int cnt, IReduceOp op, MPI_Comm comm)
+    {
+#ifdef BL_USE_MPI
+        const MPI_Op mpi_op = (op == IReduceOp::sum) ? MPI_SUM
+                            : (op == IReduceOp::max) ? MPI_MAX : MPI_MIN;
+#else
+        amrex::ignore_unused(op);
+        const MPI_Op mpi_op = 0;
+#endif
+        return Future<T>(r, cnt, mpi_op, comm);
+    }
+}
+
+Future<Real> IReduceRealSum (Real r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::sum, comm); }
+Future<Real> IReduceRealSum (const Real* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::sum, comm); }
+Future<Real> IReduceRealMax (Real r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::max, comm); }
+Future<Real> IReduceRealMax (const Real* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::max, comm); }
+Future<Real> IReduceRealMin (Real r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::min, comm); }
+Future<Real> IReduceRealMin (const Real* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::min, comm); }
+
+Future<int> IReduceIntSum (int r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::sum, comm); }
+Future<int> IReduceIntSum (const int* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::sum, comm); }
+Future<int> IReduceIntMax (int r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::max, comm); }
+Future<int> IReduceIntMax (const int* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::max, comm); }
+Future<int> IReduceIntMin (int r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::min, comm); }
+Future<int> IReduceIntMin (const int* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::min, comm); }
+
+Future<Long> IReduceLongSum (Long r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::sum, comm); }
+Future<Long> IReduceLongSum (const Long* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::sum, comm); }
+Future<Long> IReduceLongMax (Long r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::max, comm); }
+Future<Long> IReduceLongMax (const Long* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::max, comm); }
+Future<Long> IReduceLongMin (Long r, MPI_Comm comm) { return IAllReduce(&r, 1, IReduceOp::min, comm); }
+Future<Long> IReduceLongMin (const Long* r, int cnt, MPI_Comm comm) { return IAllReduce(r, cnt, IReduceOp::min, comm); }
+
 #ifndef BL_NO_FORT
 
 BL_FORT_PROC_DECL(BL_PD_BARRIER,bl_pd_barrier)()
@@ -2099,8 +2224,10 @@ Initialize ()
 #ifndef BL_AMRPROF
     ParmParse pp("amrex");
     pp.query("use_gpu_aware_mpi", use_gpu_aware_mpi);
+    pp.query("reproducible_sums", use_reproducible_sums);
 
     StartTeams();
+    StartNode();
 #endif
 }
 
@@ -2108,10 +2235,83 @@ void
 Finalize ()
 {
 #ifndef BL_AMRPROF
+    EndNode();
     EndTeams();
 #endif
 }
 
+void
+StartNode ()
+{
+#if defined(BL_USE_MPI) && (MPI_VERSION >= 3)
+    BL_MPI_REQUIRE( MPI_Comm_split_type(Communicator(), MPI_COMM_TYPE_SHARED, MyProc(),
+                                        MPI_INFO_NULL, &m_node_comm) );
+    int node_size;
+    BL_MPI_REQUIRE( MPI_Comm_size(m_node_comm, &node_size) );
+    Vector<int> ranks(node_size);
+    int myproc = MyProc();
+    BL_MPI_REQUIRE( MPI_Allgather(&myproc, 1, MPI_INT, ranks.data(), 1, MPI_INT, m_node_comm) );
+    m_rank_in_node.assign(NProcs(), -1);
+    for (int i = 0; i < node_size; ++i) {
+        m_rank_in_node[ranks[i]] = i;
+    }
+
+    // The lowest rank on each node identifies the node.
+    int leader = ranks[0];
+    for (int i = 1; i < node_size; ++i) {
+        leader = std::min(leader, ranks[i]);
+    }
+    Vector<int> leaders(NProcs());
+    BL_MPI_REQUIRE( MPI_Allgather(&leader, 1, MPI_INT, leaders.data(), 1, MPI_INT,
+                                  Communicator()) );
+    m_node_of_rank.resize(NProcs());
+    m_num_nodes = 0;
+    for (int i = 0; i < NProcs(); ++i) {
+        m_node_of_rank[i] = (leaders[i] == i) ? m_num_nodes++ : m_node_of_rank[leaders[i]];
+    }
+#endif
+}
+
+void
+EndNode ()
+{
+#ifdef BL_USE_MPI
+    if (m_node_comm != MPI_COMM_NULL) {
+        MPI_Comm_free(&m_node_comm);
+    }
+    if (m_node_shm_info != MPI_INFO_NULL) {
+        MPI_Info_free(&m_node_shm_info);
+    }
+#endif
+    m_rank_in_node.clear();
+    m_node_of_rank.clear();
+    m_num_nodes = 1;
+}
+
+#ifdef BL_USE_MPI
+MPI_Info
+NodeShmInfo ()
+{
+    if (m_node_shm_info == MPI_INFO_NULL) {
+        BL_MPI_REQUIRE( MPI_Info_create(&m_node_shm_info) );
+        BL_MPI_REQUIRE( MPI_Info_set(m_node_shm_info, "alloc_shared_noncontig", "true") );
+    }
+    return m_node_shm_info;
+}
+#endif
+
+void
+NodeMemoryBarrier ()
+{
+#ifdef BL_USE_MPI
+    if (m_node_comm != MPI_COMM_NULL) {
+        std::atomic_thread_fence(std::memory_order_release);
+        BL_MPI_REQUIRE( MPI_Barrier(m_node_comm) );
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+#endif
+}
+
 #ifndef BL_AMRPROF
 void
 StartTeams ()
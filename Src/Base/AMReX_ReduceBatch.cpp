@@ -0,0 +1,215 @@
+#include <AMReX_ReduceBatch.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_ReproducibleSum.H>
+
+#include <algorithm>
+
+namespace amrex {
+
+namespace detail {
+
+namespace {
+
+    template <typename T>
+    void combine (BatchOp op, char* inout, const char* in)
+    {
+        T a, b;
+        std::memcpy(&a, in, sizeof(T));
+        std::memcpy(&b, inout, sizeof(T));
+        switch (op) {
+        case BatchOp::sum:  b += a;                          break;
+        case BatchOp::min:  b = std::min(a,b);               break;
+        case BatchOp::max:  b = std::max(a,b);               break;
+        case BatchOp::land: b = static_cast<T>(a && b);      break;
+        case BatchOp::lor:  b = static_cast<T>(a || b);      break;
+        case BatchOp::none:                                  break;
+        }
+        std::memcpy(inout, &b, sizeof(T));
+    }
+
+#ifdef BL_USE_MPI
+    MPI_Datatype mpi_type_batch_entry = MPI_DATATYPE_NULL;
+    MPI_Op       mpi_op_batch = MPI_OP_NULL;
+
+    void batch_reduce (void* invec, void* inoutvec, int* len, MPI_Datatype*)
+    {
+        const BatchEntry* in = static_cast<const BatchEntry*>(invec);
+        BatchEntry* inout = static_cast<BatchEntry*>(inoutvec);
+        for (int i = 0; i < *len; ++i)
+        {
+            const BatchOp op = inout[i].op;
+            switch (inout[i].type) {
+            case BatchType::Int:      combine<int      >(op, inout[i].value, in[i].value); break;
+            case BatchType::Long:     combine<long     >(op, inout[i].value, in[i].value); break;
+            case BatchType::LongLong: combine<long long>(op, inout[i].value, in[i].value); break;
+            case BatchType::Float:    combine<float    >(op, inout[i].value, in[i].value); break;
+            case BatchType::Double:   combine<double   >(op, inout[i].value, in[i].value); break;
+            }
+        }
+    }
+
+    void free_mpi_batch_type ()
+    {
+        if (mpi_op_batch != MPI_OP_NULL) {
+            BL_MPI_REQUIRE( MPI_Op_free(&mpi_op_batch) );
+            BL_MPI_REQUIRE( MPI_Type_free(&mpi_type_batch_entry) );
+            mpi_op_batch = MPI_OP_NULL;
+            mpi_type_batch_entry = MPI_DATATYPE_NULL;
+        }
+    }
+
+    template <typename T>
+    T entry_value (BatchEntry const& e)
+    {
+        T v;
+        std::memcpy(&v, e.value, sizeof(T));
+        return v;
+    }
+
+    template <typename T>
+    void set_entry_value (BatchEntry& e, T v)
+    {
+        std::memcpy(e.value, &v, sizeof(T));
+    }
+
+    /**
+    * \brief Reduce the floating-point sums of the batch with exact sums,
+    * all with one call, and mark them as reduced.
+    */
+    void reproducible_sums (Vector<BatchEntry>& entries, MPI_Comm comm)
+    {
+        Vector<int> idx;
+        Vector<double> v;
+        for (int i = 0; i < entries.size(); ++i) {
+            BatchEntry const& e = entries[i];
+            if (e.op == BatchOp::sum) {
+                if (e.type == BatchType::Double) {
+                    idx.push_back(i);
+                    v.push_back(entry_value<double>(e));
+                } else if (e.type == BatchType::Float) {
+                    idx.push_back(i);
+                    v.push_back(entry_value<float>(e));
+                }
+            }
+        }
+        if (idx.empty()) return;
+
+        ReproducibleSum::ParallelSum(v.data(), v.size(), comm);
+
+        for (int n = 0; n < idx.size(); ++n) {
+            BatchEntry& e = entries[idx[n]];
+            if (e.type == BatchType::Double) {
+                set_entry_value(e, v[n]);
+            } else {
+                set_entry_value(e, static_cast<float>(v[n]));
+            }
+            e.op = BatchOp::none;
+        }
+    }
+
+    void init_mpi_batch_type ()
+    {
+        if (mpi_op_batch == MPI_OP_NULL) {
+            BL_MPI_REQUIRE( MPI_Type_contiguous(sizeof(BatchEntry), MPI_BYTE, &mpi_type_batch_entry) );
+            BL_MPI_REQUIRE( MPI_Type_commit(&mpi_type_batch_entry) );
+            BL_MPI_REQUIRE( MPI_Op_create(batch_reduce, 1, &mpi_op_batch) );
+            amrex::ExecOnFinalize(free_mpi_batch_type);
+        }
+    }
+#endif
+}
+
+ReduceBatchState::~ReduceBatchState ()
+{
+    // An MPI request has to be completed even if nobody wants the result.
+    if (m_posted) m_msg.wait();
+}
+
+void
+ReduceBatchState::post ()
+{
+    if (m_posted) return;
+    m_posted = true;
+
+    BL_PROFILE("ReduceBatch::Post()");
+
+#ifdef BL_USE_MPI
+    int nprocs;
+    MPI_Comm_size(m_comm, &nprocs);
+    if (nprocs > 1 && ParallelDescriptor::UseReproducibleSums()) {
+        reproducible_sums(m_entries, m_comm);
+    }
+#endif
+
+    m_result = m_entries;
+
+#ifdef BL_USE_MPI
+    if (!m_entries.empty() && nprocs > 1)
+    {
+        init_mpi_batch_type();
+#if defined(MPI_VERSION) && (MPI_VERSION >= 3)
+        MPI_Request req;
+        BL_MPI_REQUIRE( MPI_Iallreduce(m_entries.data(), m_result.data(), m_entries.size(),
+                                       mpi_type_batch_entry, mpi_op_batch, m_comm, &req) );
+        m_msg = ParallelDescriptor::Message(req, mpi_type_batch_entry);
+#else
+        BL_MPI_REQUIRE( MPI_Allreduce(m_entries.data(), m_result.data(), m_entries.size(),
+                                      mpi_type_batch_entry, mpi_op_batch, m_comm) );
+#endif
+    }
+#endif
+}
+
+bool
+ReduceBatchState::test ()
+{
+    post();
+    return m_msg.test();
+}
+
+void
+ReduceBatchState::wait ()
+{
+    post();
+    BL_PROFILE("ReduceBatch::Wait()");
+    m_msg.wait();
+}
+
+}
+
+ReduceBatch::~ReduceBatch ()
+{
+    if (m_state && !m_state->posted() && m_state->size() > 0) {
+        m_state->post();
+    }
+}
+
+detail::ReduceBatchState&
+ReduceBatch::state ()
+{
+    if (!m_state || m_state->posted()) {
+        m_state = std::make_shared<detail::ReduceBatchState>(m_comm);
+    }
+    return *m_state;
+}
+
+void
+ReduceBatch::Post ()
+{
+    if (m_state && !m_state->posted()) {
+        m_state->post();
+    }
+    m_state.reset();
+}
+
+void
+ReduceBatch::Wait ()
+{
+    if (m_state) {
+        m_state->wait();
+    }
+    m_state.reset();
+}
+
+}
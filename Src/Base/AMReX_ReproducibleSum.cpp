@@ -0,0 +1,148 @@
+#include <AMReX_ReproducibleSum.H>
+#include <AMReX_BLProfiler.H>
+#include <AMReX_ParallelDescriptor.H>
+
+#include <cmath>
+#include <limits>
+
+namespace amrex {
+
+static_assert(sizeof(Long) == 8, "ReproducibleSum needs 64-bit integers");
+
+ReproducibleSum&
+ReproducibleSum::operator+= (const ReproducibleSum& rhs) noexcept
+{
+    if (rhs.m_single) {
+        add(rhs.m_value);
+    } else if (m_single) {
+        const double v = m_value;
+        copy(rhs);
+        add(v);
+    } else {
+        // rhs.m_nadd < max_nadd, so the bins cannot overflow
+        if (m_nadd + rhs.m_nadd >= max_nadd) normalize();
+        for (int i = 0; i < nwords; ++i) {
+            m_acc[i] += rhs.m_acc[i];
+        }
+        m_nadd += rhs.m_nadd;
+        if (m_nadd >= max_nadd) normalize();
+    }
+    return *this;
+}
+
+void
+ReproducibleSum::normalize () noexcept
+{
+    if (m_single) return;
+    for (int i = 0; i < nbins-1; ++i) {
+        const Long lo = m_acc[i] & Long(0xffffffff);
+        m_acc[i+1] += (m_acc[i] - lo) / (Long(1) << 32);
+        m_acc[i] = lo;
+    }
+    m_nadd = 1;
+}
+
+double
+ReproducibleSum::value () const noexcept
+{
+    if (m_single) return m_value;
+
+    if (m_acc[nan_pos] > 0 || (m_acc[inf_pos] > 0 && m_acc[inf_neg] > 0)) {
+        return std::numeric_limits<double>::quiet_NaN();
+    } else if (m_acc[inf_pos] > 0) {
+        return std::numeric_limits<double>::infinity();
+    } else if (m_acc[inf_neg] > 0) {
+        return -std::numeric_limits<double>::infinity();
+    }
+
+    // The normalized bins are a unique representation of the sum, with
+    // the sign in the last bin.
+    ReproducibleSum s(*this);
+    s.normalize();
+    const bool neg = s.m_acc[nbins-1] < 0;
+    if (neg) {
+        for (int i = 0; i < nbins; ++i) { s.m_acc[i] = -s.m_acc[i]; }
+        s.normalize();
+    }
+
+    int h = nbins-1;
+    while (h >= 0 && s.m_acc[h] == 0) { --h; }
+    if (h < 0) return 0.0;
+
+    if (s.m_acc[h] >> 32) {
+        return neg ? -std::numeric_limits<double>::infinity()
+                   :  std::numeric_limits<double>::infinity();
+    }
+
+    // The 64 bits from the leading one down, with the bits below them
+    // folded into the last one, round to the same double as the sum.
+    const auto bin = [&] (int i) -> std::uint64_t {
+        return (i >= 0) ? static_cast<std::uint64_t>(s.m_acc[i]) : 0;
+    };
+    int lz = 0;
+    while (((bin(h) << lz) & 0x80000000ULL) == 0) { ++lz; }
+    std::uint64_t m = (bin(h) << (32+lz)) | (bin(h-1) << lz);
+    bool sticky = false;
+    if (lz > 0) {
+        m |= bin(h-2) >> (32-lz);
+        sticky = (bin(h-2) & ((std::uint64_t(1) << (32-lz)) - 1)) != 0;
+    } else {
+        sticky = bin(h-2) != 0;
+    }
+    for (int i = h-3; i >= 0 && !sticky; --i) {
+        sticky = s.m_acc[i] != 0;
+    }
+    if (sticky) m |= 1;
+
+    const double r = std::ldexp(static_cast<double>(m), 32*h - 1106 - lz);
+    return neg ? -r : r;
+}
+
+void
+ReproducibleSum::ParallelSum (MPI_Comm comm, int root)
+{
+    ParallelSum(this, 1, comm, root);
+}
+
+void
+ReproducibleSum::ParallelSum (ReproducibleSum* s, int cnt, MPI_Comm comm, int root)
+{
+#ifdef BL_USE_MPI
+    BL_PROFILE("ReproducibleSum::ParallelSum()");
+
+    int nprocs;
+    BL_MPI_REQUIRE( MPI_Comm_size(comm, &nprocs) );
+    if (nprocs == 1 || cnt <= 0) return;
+
+    // After normalization, the bins of each process are less than 2^32,
+    // except the last one, so their sums cannot overflow.
+    Vector<Long> buf(cnt*nwords);
+    for (int n = 0; n < cnt; ++n) {
+        if (s[n].m_single) s[n].spread();
+        s[n].normalize();
+        std::memcpy(buf.data()+n*nwords, s[n].m_acc, sizeof(s[n].m_acc));
+    }
+
+    MPI_Datatype t = ParallelDescriptor::Mpi_typemap<Long>::type();
+    int myproc;
+    BL_MPI_REQUIRE( MPI_Comm_rank(comm, &myproc) );
+    if (root < 0) {
+        BL_MPI_REQUIRE( MPI_Allreduce(MPI_IN_PLACE, buf.data(), buf.size(), t, MPI_SUM, comm) );
+    } else if (myproc == root) {
+        BL_MPI_REQUIRE( MPI_Reduce(MPI_IN_PLACE, buf.data(), buf.size(), t, MPI_SUM, root, comm) );
+    } else {
+        BL_MPI_REQUIRE( MPI_Reduce(buf.data(), nullptr, buf.size(), t, MPI_SUM, root, comm) );
+        return;
+    }
+
+    for (int n = 0; n < cnt; ++n) {
+        std::memcpy(s[n].m_acc, buf.data()+n*nwords, sizeof(s[n].m_acc));
+        s[n].m_nadd = nprocs;
+        s[n].normalize();
+    }
+#else
+    amrex::ignore_unused(s, cnt, comm, root);
+#endif
+}
+
+}
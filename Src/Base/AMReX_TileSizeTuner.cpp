@@ -0,0 +1,228 @@
+#include <AMReX_TileSizeTuner.H>
+#include <AMReX.H>
+#include <AMReX_GpuControl.H>
+#include <AMReX_OpenMP.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <sstream>
+
+namespace amrex {
+
+namespace {
+
+    struct TunedLoop
+    {
+        std::string     name;
+        IntVect         shape;
+        int             ncomp;
+        Vector<IntVect> candidates;
+        Vector<double>  time;       // The fastest run of each candidate
+        int             ncalls = 0;
+        int             best = -1;
+    };
+
+    bool tile_tuning = true;
+    int  tile_tuning_trials = 3;
+
+    Vector<IntVect>            tile_candidates;
+    Vector<TunedLoop>          tuned_loops;
+    std::map<std::string,int>  tuned_loop_ids;
+
+    std::string loop_key (const std::string& name, const IntVect& shape, int ncomp)
+    {
+        std::ostringstream os;
+        os << name << ' ' << shape << ' ' << ncomp;
+        return os.str();
+    }
+
+    IntVect loop_shape (const FabArrayBase& fa)
+    {
+        IntVect shape(0);
+        for (int K : fa.IndexArray()) {
+            shape.max(fa.boxArray().getCellCenteredBox(K).length());
+        }
+        return shape;
+    }
+
+    int find_loop (const std::string& name, const IntVect& shape, int ncomp)
+    {
+        const std::string key = loop_key(name, shape, ncomp);
+        auto it = tuned_loop_ids.find(key);
+        if (it != tuned_loop_ids.end()) return it->second;
+
+        //
+        // Tile sizes larger than the FABs make one tile in that direction,
+        // so the candidates are clipped to the shape and repeats are dropped.
+        //
+        TunedLoop loop;
+        loop.name = name;
+        loop.shape = shape;
+        loop.ncomp = ncomp;
+        for (auto const& c : tile_candidates) {
+            const IntVect ts = amrex::min(c, shape);
+            if (std::find(loop.candidates.begin(), loop.candidates.end(), ts)
+                == loop.candidates.end()) {
+                loop.candidates.push_back(ts);
+            }
+        }
+        loop.time.resize(loop.candidates.size(), std::numeric_limits<double>::max());
+        if (loop.candidates.size() == 1) loop.best = 0;
+
+        const int id = tuned_loops.size();
+        tuned_loops.push_back(std::move(loop));
+        tuned_loop_ids[key] = id;
+        return id;
+    }
+
+    Vector<IntVect> default_candidates ()
+    {
+        Vector<IntVect> c{FabArrayBase::mfiter_tile_size};
+#if (AMREX_SPACEDIM > 1)
+        for (int s : {4, 8, 16, 32}) {
+            IntVect ts(s);
+            ts[0] = 1024000;
+            c.push_back(ts);
+        }
+#endif
+        for (int s : {16, 32, 64}) {
+            c.push_back(IntVect(s));
+        }
+        c.push_back(IntVect(1024000));
+        return c;
+    }
+}
+
+void
+TileSizeTuner::Initialize ()
+{
+    tile_candidates = default_candidates();
+
+    ParmParse pp("fabarray");
+    pp.query("mfiter_tile_tuning", tile_tuning);
+    pp.query("mfiter_tile_tuning_trials", tile_tuning_trials);
+    tile_tuning_trials = std::max(tile_tuning_trials, 1);
+
+    Vector<int> c;
+    if (pp.queryarr("mfiter_tile_tuning_candidates", c)) {
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(!c.empty() && c.size() % AMREX_SPACEDIM == 0,
+            "fabarray.mfiter_tile_tuning_candidates must have AMREX_SPACEDIM numbers per tile size");
+        Vector<IntVect> candidates;
+        for (int i = 0; i < c.size(); i += AMREX_SPACEDIM) {
+            candidates.push_back(IntVect(&c[i]));
+        }
+        SetCandidates(candidates);
+    }
+
+    amrex::ExecOnFinalize(TileSizeTuner::Finalize);
+}
+
+void
+TileSizeTuner::Finalize ()
+{
+    Reset();
+    tile_candidates.clear();
+}
+
+TileSizeTuner::TileSizeTuner (const std::string& name, const FabArrayBase& fa)
+    : m_tile_size(FabArrayBase::mfiter_tile_size)
+{
+    if (!tile_tuning || Gpu::inLaunchRegion() || fa.IndexArray().empty()) return;
+
+    AMREX_ASSERT_WITH_MESSAGE(!OpenMP::in_parallel(),
+                              "TileSizeTuner must be made outside OpenMP parallel regions");
+
+    m_entry = find_loop(name, loop_shape(fa), fa.nComp());
+    TunedLoop const& loop = tuned_loops[m_entry];
+    if (loop.best >= 0) {
+        m_tile_size = loop.candidates[loop.best];
+    } else {
+        // Take the candidates in turn, so that slow first runs are not
+        // all charged to the same one.
+        m_candidate = loop.ncalls % loop.candidates.size();
+        m_tile_size = loop.candidates[m_candidate];
+        m_start = amrex::second();
+    }
+}
+
+TileSizeTuner::~TileSizeTuner ()
+{
+    if (m_candidate < 0) return;
+
+    const double t = amrex::second() - m_start;
+
+    TunedLoop& loop = tuned_loops[m_entry];
+    if (loop.best >= 0) return;  // A nested tuner of the same loop finished first.
+
+    loop.time[m_candidate] = std::min(loop.time[m_candidate], t);
+    ++loop.ncalls;
+
+    const int ncand = loop.candidates.size();
+    if (loop.ncalls >= ncand*tile_tuning_trials)
+    {
+        loop.best = std::min_element(loop.time.begin(), loop.time.end()) - loop.time.begin();
+        if (amrex::Verbose() > 1) {
+            amrex::Print() << "TileSizeTuner: " << loop.name << " on " << loop.shape
+                           << " x " << loop.ncomp << " uses tile size "
+                           << loop.candidates[loop.best] << ", "
+                           << loop.time[0]/loop.time[loop.best]
+                           << " times as fast as " << loop.candidates[0] << "\n";
+        }
+    }
+}
+
+IntVect
+TileSizeTuner::Best (const std::string& name, const FabArrayBase& fa)
+{
+    auto it = tuned_loop_ids.find(loop_key(name, loop_shape(fa), fa.nComp()));
+    if (it != tuned_loop_ids.end()) {
+        TunedLoop const& loop = tuned_loops[it->second];
+        if (loop.best >= 0) return loop.candidates[loop.best];
+    }
+    return IntVect::TheZeroVector();
+}
+
+void
+TileSizeTuner::SetCandidates (const Vector<IntVect>& candidates)
+{
+    AMREX_ALWAYS_ASSERT(!candidates.empty());
+    tile_candidates = candidates;
+    Reset();
+}
+
+const Vector<IntVect>&
+TileSizeTuner::Candidates () noexcept
+{
+    return tile_candidates;
+}
+
+void
+TileSizeTuner::Reset ()
+{
+    tuned_loops.clear();
+    tuned_loop_ids.clear();
+}
+
+void
+TileSizeTuner::PrintSummary ()
+{
+    for (auto const& loop : tuned_loops)
+    {
+        amrex::Print() << "TileSizeTuner: " << loop.name << " on " << loop.shape
+                       << " x " << loop.ncomp;
+        if (loop.best >= 0) {
+            amrex::Print() << ": tile size " << loop.candidates[loop.best]
+                           << ", " << loop.time[0]/loop.time[loop.best]
+                           << " times as fast as " << loop.candidates[0] << "\n";
+        } else {
+            amrex::Print() << ": tuning, " << loop.ncalls << " of "
+                           << loop.candidates.size()*tile_tuning_trials << " runs\n";
+        }
+    }
+}
+
+}
@@ -8,6 +8,7 @@
 #include <set>
 
 #include <AMReX_TinyProfiler.H>
+#include <AMReX_FabArrayBase.H>
 #include <AMReX_ParallelDescriptor.H>
 #include <AMReX_ParallelReduce.H>
 #include <AMReX_Utility.H>
@@ -355,6 +356,10 @@ TinyProfiler::Finalize (bool bFlushing) noexcept
             amrex::Print() << "END REGION " << kv.first << "\n";
         }
     }
+
+    if (!bFlushing && FabArrayBase::print_cache_stats) {
+        FabArrayBase::printCacheStats();
+    }
 }
 
 void
@@ -570,6 +575,12 @@ TinyProfiler::StopRegion (const std::string& regname) noexcept
     }
 }
 
+bool
+TinyProfiler::InRegion (const std::string& regname) noexcept
+{
+    return std::find(regionstack.begin(), regionstack.end(), regname) != regionstack.end();
+}
+
 TinyProfileRegion::TinyProfileRegion (std::string a_regname) noexcept
     : regname(std::move(a_regname)),
       tprof(std::string("REG::")+regname, false, false)
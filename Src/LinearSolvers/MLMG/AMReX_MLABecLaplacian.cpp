@@ -396,6 +396,10 @@ MLABecLaplacian::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& i
 
     const int ncomp = getNComp();
 
+#if (AMREX_SPACEDIM == 3)
+    const bool use_simd = info.use_simd_kernels && Gpu::notInLaunchRegion();
+#endif
+
 #ifdef _OPENMP
 #pragma omp parallel if (Gpu::notInLaunchRegion())
 #endif
@@ -415,7 +419,14 @@ MLABecLaplacian::Fapply (int amrlev, int mglev, MultiFab& out, const MultiFab& i
                 mlabeclap_adotx_os(tbx, yfab, xfab, afab, AMREX_D_DECL(bxfab,byfab,bzfab),
                                    osm, dxinv, ascalar, bscalar, ncomp);
             });
-        } else {
+        } else
+#if (AMREX_SPACEDIM == 3)
+        if (use_simd) {
+            mlabeclap_adotx_simd(bx, yfab, xfab, afab, bxfab, byfab, bzfab,
+                                 dxinv, ascalar, bscalar, ncomp);
+        } else
+#endif
+        {
             AMREX_LAUNCH_HOST_DEVICE_FUSIBLE_LAMBDA ( bx, tbx,
             {
                 mlabeclap_adotx(tbx, yfab, xfab, afab, AMREX_D_DECL(bxfab,byfab,bzfab),
@@ -471,6 +482,9 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
     if (amrlev == 0 and mglev > 0) {
         regular_coarsening = mg_coarsen_ratio_vec[mglev-1] == mg_coarsen_ratio;
     }
+#if (AMREX_SPACEDIM == 3) && !defined(AMREX_USE_DPCPP)
+    const bool use_simd = info.use_simd_kernels && Gpu::notInLaunchRegion();
+#endif
 
     const MultiFab& acoef = m_a_coeffs[amrlev][mglev];
     AMREX_D_TERM(const MultiFab& bxcoef = m_b_coeffs[amrlev][mglev][0];,
@@ -620,6 +634,17 @@ MLABecLaplacian::Fsmooth (int amrlev, int mglev, MultiFab& sol, const MultiFab&
                              AMREX_D_DECL(f1fab,f3fab,f5fab),
                              osm, vbx, redblack, nc);
             });
+#if (AMREX_SPACEDIM == 3)
+        } else if (regular_coarsening && use_simd) {
+            abec_gsrb_simd(tbx, solnfab, rhsfab, alpha, afab,
+                           dhx, dhy, dhz,
+                           bxfab, byfab, bzfab,
+                           m0, m2, m4,
+                           m1, m3, m5,
+                           f0fab, f2fab, f4fab,
+                           f1fab, f3fab, f5fab,
+                           vbx, redblack, nc);
+#endif
         } else if (regular_coarsening) {
             AMREX_LAUNCH_HOST_DEVICE_FUSIBLE_LAMBDA ( tbx, thread_box,
             {
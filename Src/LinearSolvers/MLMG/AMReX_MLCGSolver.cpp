@@ -5,6 +5,7 @@
 #include <AMReX_MLCGSolver.H>
 #include <AMReX_VisMF.H>
 #include <AMReX_ParallelReduce.H>
+#include <AMReX_ReduceBatch.H>
 #include <AMReX_MLMG.H>
 
 #ifdef _OPENMP
@@ -73,6 +74,9 @@ MLCGSolver::solve (MultiFab&       sol,
 {
     if (solver_type == Type::BiCGStab) {
         return solve_bicgstab(sol,rhs,eps_rel,eps_abs);
+    } else if (overlap_reduction && ParallelDescriptor::NProcs() > 1 &&
+               !ParallelDescriptor::UseReproducibleSums()) {
+        return solve_cg_pipelined(sol,rhs,eps_rel,eps_abs);
     } else {
         return solve_cg(sol,rhs,eps_rel,eps_abs);
     }
@@ -118,7 +122,9 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
 
     sol.setVal(0);
 
-    Real rnorm = norm_inf(r);
+    // rh is r, so the rho of the first iteration is reduced along with the norm.
+    Real rnorm, rho;
+    norm_inf_dotxy(r, rh, rnorm, rho);
     const Real rnorm0   = rnorm;
 
     if ( verbose > 0 )
@@ -142,7 +148,6 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
 
     for (; iter <= maxiter; ++iter)
     {
-        const Real rho = dotxy(rh,r);
         if ( rho == 0 ) 
 	{
             ret = 1; break;
@@ -176,7 +181,24 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
         //Subtract mean from s 
 //        if (Lp.isBottomSingular()) mlmg->makeSolvable(amrlev, mglev, s);
  
-        rnorm = norm_inf(s);
+        if (overlap_reduction)
+        {
+            // The reduction of the norm overlaps with the apply, which does
+            // not need it.  If s has converged, t is not used.
+            auto snorm = ParallelDescriptor::IReduceRealMax(norm_inf(s,true),
+                                                            Lp.BottomCommunicator());
+
+            MultiFab::Copy(sh,s,0,0,ncomp,nghost);
+            Lp.apply(amrlev, mglev, t, sh, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+            Lp.normalize(amrlev, mglev, t);
+
+            BL_PROFILE("MLCGSolver::ParallelAllReduce");
+            rnorm = snorm.get();
+        }
+        else
+        {
+            rnorm = norm_inf(s);
+        }
 
         if ( verbose > 2 && ParallelDescriptor::IOProcessor() )
         {
@@ -188,19 +210,34 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
 
         if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
 
-        MultiFab::Copy(sh,s,0,0,ncomp,nghost);
-        Lp.apply(amrlev, mglev, t, sh, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
-        Lp.normalize(amrlev, mglev, t);
+        if (!overlap_reduction)
+        {
+            MultiFab::Copy(sh,s,0,0,ncomp,nghost);
+            Lp.apply(amrlev, mglev, t, sh, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+            Lp.normalize(amrlev, mglev, t);
+        }
         //
         // This is a little funky.  I want to elide one of the reductions
         // in the following two dotxy()s.  We do that by calculating the "local"
         // values and then reducing the two local values at the same time.
         //
-        Real tvals[2] = { dotxy(t,t,true), dotxy(t,s,true) };
-
-        BL_PROFILE_VAR("MLCGSolver::ParallelAllReduce", blp_par);
-        ParallelAllReduce::Sum(tvals,2,Lp.BottomCommunicator());
-        BL_PROFILE_VAR_STOP(blp_par);
+        Real tvals[2];
+        if (ParallelDescriptor::UseReproducibleSums())
+        {
+            // The sum of the rounded local values would depend on the
+            // decomposition.
+            tvals[0] = dotxy(t,t);
+            tvals[1] = dotxy(t,s);
+        }
+        else
+        {
+            ReduceBatch batch(Lp.BottomCommunicator());
+            auto tt = batch.Sum(dotxy(t,t,true));
+            auto ts = batch.Sum(dotxy(t,s,true));
+            BL_PROFILE("MLCGSolver::ParallelAllReduce");
+            tvals[0] = tt.get();
+            tvals[1] = ts.get();
+        }
 
         if ( tvals[0] != Real(0.0) )
 	{
@@ -215,7 +252,9 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
 
 //        if (Lp.isBottomSingular()) mlmg->makeSolvable(amrlev, mglev, r);
 
-        rnorm = norm_inf(r);
+        // The rho of the next iteration is reduced along with the norm.
+        Real rho_next;
+        norm_inf_dotxy(r, rh, rnorm, rho_next);
 
         if ( verbose > 2 )
         {
@@ -232,6 +271,7 @@ MLCGSolver::solve_bicgstab (MultiFab&       sol,
             ret = 4; break;
 	}
         rho_1 = rho;
+        rho = rho_next;
     }
 
     if ( verbose > 0 )
@@ -290,7 +330,9 @@ MLCGSolver::solve_cg (MultiFab&       sol,
 
     sol.setVal(0);
 
-    Real       rnorm    = norm_inf(r);
+    // z is r, so the rho of the first iteration is reduced along with the norm.
+    Real rnorm, rho;
+    norm_inf_dotxy(r, r, rnorm, rho);
     const Real rnorm0   = rnorm;
 
     if ( verbose > 0 )
@@ -316,8 +358,6 @@ MLCGSolver::solve_cg (MultiFab&       sol,
     {
         MultiFab::Copy(z,r,0,0,ncomp,nghost);
 
-        Real rho = dotxy(z,r);
-
         if ( rho == 0 )
         {
             ret = 1; break;
@@ -353,7 +393,8 @@ MLCGSolver::solve_cg (MultiFab&       sol,
         }
         sxay(sol, sol, alpha, p, nghost);
         sxay(  r,   r,-alpha, q, nghost);
-        rnorm = norm_inf(r);
+        Real rho_next;
+        norm_inf_dotxy(r, r, rnorm, rho_next);
 
         if ( verbose > 2 )
         {
@@ -366,6 +407,7 @@ MLCGSolver::solve_cg (MultiFab&       sol,
         if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
 
         rho_1 = rho;
+        rho = rho_next;
     }
     
     if ( verbose > 0 )
@@ -396,6 +438,174 @@ MLCGSolver::solve_cg (MultiFab&       sol,
     return ret;
 }
 
+int
+MLCGSolver::solve_cg_pipelined (MultiFab&       sol,
+                                const MultiFab& rhs,
+                                Real            eps_rel,
+                                Real            eps_abs)
+{
+    BL_PROFILE("MLCGSolver::cg_pipelined");
+
+    // P. Ghysels and W. Vanroose, Hiding global synchronization latency in
+    // the preconditioned Conjugate Gradient algorithm, Parallel Computing
+    // 40 (2014), without preconditioner.  The recurrences give w = A r,
+    // s = A p and z = A s.
+
+    const int ncomp = sol.nComp();
+
+    const BoxArray& ba = sol.boxArray();
+    const DistributionMapping& dm = sol.DistributionMap();
+    const auto& factory = sol.Factory();
+
+    // The operator is applied to r and w, which need ghost cells.
+    MultiFab r(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    MultiFab w(ba, dm, ncomp, sol.nGrow(), MFInfo(), factory);
+    r.setVal(0.0);
+    w.setVal(0.0);
+
+    MultiFab sorig(ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab p    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab s    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab z    (ba, dm, ncomp, nghost, MFInfo(), factory);
+    MultiFab q    (ba, dm, ncomp, nghost, MFInfo(), factory);
+
+    MultiFab::Copy(sorig,sol,0,0,ncomp,nghost);
+
+    Lp.correctionResidual(amrlev, mglev, r, sol, rhs, MLLinOp::BCMode::Homogeneous);
+
+    sol.setVal(0);
+
+    Lp.apply(amrlev, mglev, w, r, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+    Real rnorm = 0, rnorm0 = 0;
+    Real gamma_1 = 0, alpha = 0;
+    int  ret = 0;
+
+    for (iter = 0; ; ++iter)
+    {
+        // The norm of r and the two dot products are reduced together, and
+        // the reduction overlaps with the apply.  In the iteration that
+        // converges, q is not used.
+        ReduceBatch batch(Lp.BottomCommunicator());
+        auto fnorm  = batch.Max(norm_inf(r,true));
+        auto fgamma = batch.Sum(dotxy(r,r,true));
+        auto fdelta = batch.Sum(dotxy(w,r,true));
+        batch.Post();
+
+        Lp.apply(amrlev, mglev, q, w, MLLinOp::BCMode::Homogeneous, MLLinOp::StateMode::Correction);
+
+        Real gamma, delta;
+        {
+            BL_PROFILE("MLCGSolver::ParallelAllReduce");
+            rnorm = fnorm.get();
+            gamma = fgamma.get();
+            delta = fdelta.get();
+        }
+
+        if (iter == 0)
+        {
+            rnorm0 = rnorm;
+            if ( verbose > 0 )
+            {
+                amrex::Print() << "MLCGSolver_CG: Initial error (error0) :        " << rnorm0 << '\n';
+            }
+            if ( rnorm0 == 0 || rnorm0 < eps_abs )
+            {
+                if ( verbose > 0 ) {
+                    amrex::Print() << "MLCGSolver_CG: niter = 0,"
+                                   << ", rnorm = " << rnorm
+                                   << ", eps_abs = " << eps_abs << std::endl;
+                }
+                return ret;
+            }
+        }
+        else
+        {
+            if ( verbose > 2 )
+            {
+                amrex::Print() << "MLCGSolver_cg:       Iteration"
+                               << std::setw(4) << iter
+                               << " rel. err. "
+                               << rnorm/(rnorm0) << '\n';
+            }
+
+            if ( rnorm < eps_rel*rnorm0 || rnorm < eps_abs ) break;
+        }
+
+        if (iter == maxiter) break;
+
+        if ( gamma == 0 )
+        {
+            ret = 1; break;
+        }
+        Real beta = 0;
+        Real denom = delta;
+        if (iter > 0)
+        {
+            beta = gamma/gamma_1;
+            denom = delta - beta*gamma/alpha;
+        }
+        if ( denom == Real(0.0) )
+        {
+            ret = 1; break;
+        }
+        alpha = gamma/denom;
+
+        if ( verbose > 2 )
+        {
+            amrex::Print() << "MLCGSolver_cg:"
+                           << " iter " << iter+1
+                           << " rho " << gamma
+                           << " alpha " << alpha << '\n';
+        }
+
+        if (iter == 0)
+        {
+            MultiFab::Copy(z,q,0,0,ncomp,nghost);
+            MultiFab::Copy(s,w,0,0,ncomp,nghost);
+            MultiFab::Copy(p,r,0,0,ncomp,nghost);
+        }
+        else
+        {
+            sxay(z, q, beta, z, nghost);
+            sxay(s, w, beta, s, nghost);
+            sxay(p, r, beta, p, nghost);
+        }
+        sxay(sol, sol,  alpha, p, nghost);
+        sxay(  r,   r, -alpha, s, nghost);
+        sxay(  w,   w, -alpha, z, nghost);
+
+        gamma_1 = gamma;
+    }
+
+    if ( verbose > 0 )
+    {
+        amrex::Print() << "MLCGSolver_cg: Final Iteration"
+                       << std::setw(4) << iter
+                       << " rel. err. "
+                       << rnorm/(rnorm0) << '\n';
+    }
+
+    if ( ret == 0 &&  rnorm > eps_rel*rnorm0 && rnorm > eps_abs )
+    {
+        if ( verbose > 0 && ParallelDescriptor::IOProcessor() )
+            amrex::Warning("MLCGSolver_cg: failed to converge!");
+        ret = 8;
+    }
+
+    if ( ( ret == 0 || ret == 8 ) && (rnorm < rnorm0) )
+    {
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+    else
+    {
+        sol.setVal(0);
+        sol.plus(sorig, 0, ncomp, nghost);
+    }
+
+    return ret;
+}
+
 Real
 MLCGSolver::dotxy (const MultiFab& r, const MultiFab& z, bool local)
 {
@@ -421,5 +631,25 @@ MLCGSolver::norm_inf (const MultiFab& res, bool local)
     return result;
 }
 
+void
+MLCGSolver::norm_inf_dotxy (const MultiFab& res, const MultiFab& z, Real& rnorm, Real& zdotr)
+{
+    // The gain is one reduction instead of two.  Both results are needed
+    // right away, so there is nothing for the reduction to overlap with.
+    if (ParallelDescriptor::UseReproducibleSums()) {
+        // The exact sum of the rounded local dot products would still
+        // depend on the decomposition.
+        rnorm = norm_inf(res);
+        zdotr = dotxy(z,res);
+        return;
+    }
+    ReduceBatch batch(Lp.BottomCommunicator());
+    auto fnorm = batch.Max(norm_inf(res,true));
+    auto fdot  = batch.Sum(dotxy(z,res,true));
+    BL_PROFILE("MLCGSolver::ParallelAllReduce");
+    rnorm = fnorm.get();
+    zdotr = fdot.get();
+}
+
 
 }
@@ -900,10 +900,9 @@ MLCellLinOp::xdoty (int /*amrlev*/, int /*mglev*/, const MultiFab& x, const Mult
 {
     const int ncomp = getNComp();
     const int nghost = 0;
-    Real result = MultiFab::Dot(x,0,y,0,ncomp,nghost,true);
-    if (!local) {
-        ParallelAllReduce::Sum(result, ParallelContext::CommunicatorSub());
-    }
+    // Dot does the sum over processes itself, so that it is exact with
+    // amrex.reproducible_sums=1.
+    Real result = MultiFab::Dot(x,0,y,0,ncomp,nghost,local);
     return result;
 }
 
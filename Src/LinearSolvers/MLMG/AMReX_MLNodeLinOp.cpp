@@ -151,10 +151,9 @@ MLNodeLinOp::xdoty (int amrlev, int mglev, const MultiFab& x, const MultiFab& y,
     for (int i = 0; i < ncomp; i++) {
         MultiFab::Multiply(tmp, mask, 0, i, 1, nghost);
     }
-    Real result = MultiFab::Dot(tmp,0,y,0,ncomp,nghost,true);
-    if (!local) {
-        ParallelAllReduce::Sum(result, ParallelContext::CommunicatorSub());
-    }
+    // Dot does the sum over processes itself, so that it is exact with
+    // amrex.reproducible_sums=1.
+    Real result = MultiFab::Dot(tmp,0,y,0,ncomp,nghost,local);
     return result;
 }
 
@@ -0,0 +1,222 @@
+//
+// Compare the hash and the bounding volume hierarchy (BVH) used by
+// BoxArray::intersections, complementIn and contains.
+//
+// The BoxArrays are made by recursively halving the domain until the boxes
+// are small enough.  The allowed box size grows with the distance to a few
+// random points, so that the box sizes vary from min_grid_size to
+// max_grid_size like those of the fine levels of multiscale runs.  A
+// BoxArray can also be read from a file with ba_file.
+//
+
+#include <AMReX.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_BoxList.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_RealVect.H>
+#include <AMReX_Utility.H>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <fstream>
+#include <iomanip>
+#include <random>
+
+using namespace amrex;
+
+namespace {
+
+BoxArray make_multiscale (const Box& domain, int min_grid_size, int max_grid_size,
+                          int nfeatures, bool fine_only)
+{
+    std::mt19937 gen(42);
+    Vector<RealVect> features;
+    for (int i = 0; i < nfeatures; ++i) {
+        RealVect p;
+        for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+            std::uniform_real_distribution<Real> dist(domain.smallEnd(d), domain.bigEnd(d));
+            p[d] = dist(gen);
+        }
+        features.push_back(p);
+    }
+    const Real L = 0.25*domain.longside();
+
+    BoxList bl;
+    Vector<Box> stack{domain};
+    while (!stack.empty())
+    {
+        Box bx = stack.back();
+        stack.pop_back();
+
+        Real r = std::numeric_limits<Real>::max();
+        for (auto const& p : features) {
+            Real r2 = 0.;
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                Real c = std::max(Real(bx.smallEnd(d)), std::min(Real(bx.bigEnd(d)+1), p[d]));
+                r2 += (c-p[d])*(c-p[d]);
+            }
+            r = std::min(r, std::sqrt(r2));
+        }
+        const int target = min_grid_size
+            + static_cast<int>((max_grid_size-min_grid_size)*std::min(Real(1.), r/L));
+
+        int dir;
+        const int len = bx.longside(dir);
+        if (len > target && len >= 2*min_grid_size) {
+            const int half = (len/2/min_grid_size)*min_grid_size;
+            Box hi = bx.chop(dir, bx.smallEnd(dir)+half);
+            stack.push_back(hi);
+            stack.push_back(bx);
+        } else if (!fine_only || len < max_grid_size/2) {
+            bl.push_back(bx);
+        }
+    }
+
+    return BoxArray(std::move(bl));
+}
+
+template <class F>
+double timeit (F&& f)
+{
+    double t = amrex::second();
+    f();
+    return amrex::second() - t;
+}
+
+void bench (const std::string& name, const BoxArray& ba, const Box& domain,
+            int ng, int nrounds)
+{
+    Long min_pts = std::numeric_limits<Long>::max(), max_pts = 0;
+    for (int i = 0; i < ba.size(); ++i) {
+        min_pts = std::min(min_pts, ba[i].numPts());
+        max_pts = std::max(max_pts, ba[i].numPts());
+    }
+    amrex::Print() << "\n" << name << ": " << ba.size() << " boxes, "
+                   << min_pts << " to " << max_pts << " cells per box\n"
+                   << std::setw(6) << "index"
+                   << std::setw(12) << "build"
+                   << std::setw(16) << "intersections"
+                   << std::setw(14) << "complementIn"
+                   << std::setw(12) << "contains"
+                   << std::setw(14) << "# isects" << "\n";
+
+    std::vector<std::pair<int,Box> > isects;
+    Vector<Vector<std::pair<int,Box> > > results(2);
+    Vector<Long> nisects(2), ncomplement(2);
+
+    for (int use_bvh = 0; use_bvh < 2; ++use_bvh)
+    {
+        BoxArray::use_bvh = use_bvh;
+        ba.clear_hash_bin();
+
+        double t_build = timeit([&] () { ba.intersects(ba[0]); });
+
+        double t_isects = timeit([&] () {
+            for (int n = 0; n < nrounds; ++n) {
+                nisects[use_bvh] = 0;
+                for (int i = 0; i < ba.size(); ++i) {
+                    ba.intersections(amrex::grow(ba[i],ng), isects);
+                    nisects[use_bvh] += isects.size();
+                }
+            }
+        });
+
+        // Save some of the results for comparison
+        for (int i = 0; i < ba.size(); i += std::max(1,static_cast<int>(ba.size()/1000))) {
+            ba.intersections(amrex::grow(ba[i],ng), isects);
+            std::sort(isects.begin(), isects.end(),
+                      [] (std::pair<int,Box> const& a, std::pair<int,Box> const& b)
+                      { return a.first < b.first; });
+            results[use_bvh].insert(results[use_bvh].end(), isects.begin(), isects.end());
+        }
+
+        double t_complement = timeit([&] () {
+            BoxList bl;
+            bl.complementIn(domain, ba);
+            ncomplement[use_bvh] = 0;
+            for (auto const& b : bl) {
+                ncomplement[use_bvh] += b.numPts();
+            }
+        });
+
+        bool all_contained = true;
+        double t_contains = timeit([&] () {
+            for (int i = 0; i < ba.size(); ++i) {
+                all_contained = all_contained && ba.contains(ba[i]);
+            }
+        });
+        AMREX_ALWAYS_ASSERT(all_contained);
+
+        amrex::Print() << std::setw(6) << (use_bvh ? "bvh" : "hash")
+                       << std::setw(12) << t_build
+                       << std::setw(16) << t_isects/nrounds
+                       << std::setw(14) << t_complement
+                       << std::setw(12) << t_contains
+                       << std::setw(14) << nisects[use_bvh] << "\n";
+    }
+
+    bool same = nisects[0] == nisects[1] && ncomplement[0] == ncomplement[1]
+        && results[0].size() == results[1].size();
+    for (int i = 0; same && i < results[0].size(); ++i) {
+        same = results[0][i].first == results[1][i].first
+            && results[0][i].second == results[1][i].second;
+    }
+    amrex::Print() << "  results " << (same ? "agree" : "DIFFER") << "\n";
+    AMREX_ALWAYS_ASSERT(same);
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 1024;
+        int min_grid_size = 8;
+        int max_grid_size = 128;
+        int nfeatures = 8;
+        int ng = 2;
+        int nrounds = 3;
+        std::string ba_file;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("min_grid_size", min_grid_size);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nfeatures", nfeatures);
+            pp.query("ng", ng);
+            pp.query("nrounds", nrounds);
+            pp.query("ba_file", ba_file);
+        }
+
+        const bool use_bvh_save = BoxArray::use_bvh;
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+
+        {
+            BoxArray ba(domain);
+            ba.maxSize(max_grid_size/2);
+            bench("uniform", ba, domain, ng, nrounds);
+        }
+
+        bench("multiscale",
+              make_multiscale(domain, min_grid_size, max_grid_size, nfeatures, false),
+              domain, ng, nrounds);
+
+        bench("multiscale fine level",
+              make_multiscale(domain, min_grid_size, max_grid_size, nfeatures, true),
+              domain, ng, nrounds);
+
+        if (!ba_file.empty()) {
+            BoxArray ba;
+            std::ifstream ifs(ba_file.c_str(), std::ios::in);
+            ba.readFrom(ifs);
+            bench(ba_file, ba, ba.minimalBox(), ng, nrounds);
+        }
+
+        BoxArray::use_bvh = use_bvh_save;
+    }
+    amrex::Finalize();
+}
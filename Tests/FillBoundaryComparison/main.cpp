@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <fstream>
+#include <iomanip>
 
 #ifdef _OPENMP
 #include <omp.h>
@@ -162,6 +163,86 @@ main (int argc, char* argv[])
 	std::cout << "ignore this line " << err << std::endl;
     }
 
+    //
+    // Compare the point-to-point and the neighborhood collective backends
+    // of FillBoundary for a range of message sizes.  The number of
+    // components scales the message sizes.  Run with different numbers of
+    // processes to compare across rank counts.
+    //
+    {
+        Vector<int> ncomps{1, 4, 16};
+        int nrounds_backend = nrounds/10 + 1;
+        {
+            ParmParse pp;
+            pp.queryarr("ncomps", ncomps);
+            pp.query("nrounds_backend", nrounds_backend);
+        }
+
+        if (ParallelDescriptor::IOProcessor()) {
+            std::cout << "Comparing FillBoundary backends on " << ParallelDescriptor::NProcs()
+                      << " processes, " << nrounds_backend << " rounds" << std::endl;
+            std::cout << "   ncomp      avg msg size (bytes)   point-to-point (s)   neighbor (s)" << std::endl;
+        }
+
+        const bool use_nbr_orig = FabArrayBase::use_neighbor_collective;
+
+        for (int nc : ncomps)
+        {
+            Vector<std::unique_ptr<MultiFab> > mfc(nlevels);
+            for (int lev = 0; lev < nlevels; ++lev) {
+                mfc[lev].reset(new MultiFab(bas[lev], dm, nc, 1));
+                mfc[lev]->setVal(1.0);
+            }
+
+            // Average message size of level 0.  It is the finest, because the
+            // other levels are coarsened from it.
+            Long nbytes = 0, nmsgs = 0;
+            {
+                const auto& TheFB = mfc[0]->getFB(mfc[0]->nGrowVect(), Periodicity::NonPeriodic());
+                for (auto const& kv : *TheFB.m_SndTags) {
+                    for (auto const& cct : kv.second) {
+                        nbytes += cct.sbox.numPts() * nc * sizeof(Real);
+                    }
+                    ++nmsgs;
+                }
+                ParallelDescriptor::ReduceLongSum(nbytes);
+                ParallelDescriptor::ReduceLongSum(nmsgs);
+            }
+
+            Real t[2];
+            for (int ib = 0; ib < 2; ++ib)
+            {
+                FabArrayBase::use_neighbor_collective = (ib == 1);
+                // warm up the caches
+                for (int lev = 0; lev < nlevels; ++lev) {
+                    mfc[lev]->FillBoundary();
+                }
+
+                ParallelDescriptor::Barrier();
+                Real t0 = ParallelDescriptor::second();
+                for (int iround = 0; iround < nrounds_backend; ++iround) {
+                    for (int lev = 0; lev < nlevels; ++lev) {
+                        mfc[lev]->FillBoundary_nowait();
+                        mfc[lev]->FillBoundary_finish();
+                    }
+                }
+                ParallelDescriptor::Barrier();
+                t[ib] = ParallelDescriptor::second() - t0;
+            }
+
+            if (ParallelDescriptor::IOProcessor()) {
+                std::cout << std::setw(8) << nc
+                          << std::setw(26) << (nmsgs > 0 ? nbytes/nmsgs : 0)
+                          << std::setw(21) << t[0]
+                          << std::setw(15) << t[1] << std::endl;
+            }
+
+            mfc.clear();
+        }
+
+        FabArrayBase::use_neighbor_collective = use_nbr_orig;
+    }
+
     //
     // When MPI3 shared memory is used, the dtor of MultiFab calls MPI
     // functions.  Because the scope of mfs is beyond the call to
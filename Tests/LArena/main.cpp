@@ -0,0 +1,114 @@
+//
+// Check that LArena recycles its buffer only when the memory obtained
+// since the start of a Scope has been freed, with nested Scopes and with
+// blocks freed in any order.  Errors are turned into exceptions, so that
+// the checks that must fail can be tested.
+//
+
+#include <AMReX.H>
+#include <AMReX_Exception.H>
+#include <AMReX_LArena.H>
+#include <AMReX_Print.H>
+
+using namespace amrex;
+
+namespace {
+
+int nfailures = 0;
+
+void check (bool ok, const char* what)
+{
+    if (!ok) {
+        amrex::Print() << "FAILED: " << what << "\n";
+        ++nfailures;
+    }
+}
+
+bool throws (void (*f) (LArena&), LArena& ar)
+{
+    try {
+        f(ar);
+    } catch (RuntimeError const&) {
+        return true;
+    }
+    return false;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        const int throw_exception = amrex::system::throw_exception;
+        amrex::system::throw_exception = 1;
+
+        const std::size_t blk = 1024;
+        LArena ar(64*blk);
+
+        // Nested scopes, with the blocks of the inner one freed out of order
+        void* a = ar.alloc(blk);
+        const std::size_t used_a = ar.used();
+        {
+            LArena::Scope outer(&ar);
+            void* b = ar.alloc(blk);
+            const std::size_t used_b = ar.used();
+            {
+                LArena::Scope inner(&ar);
+                void* c = ar.alloc(blk);
+                void* d = ar.alloc(blk);
+                check(!inner.canRecycle(), "inner scope with live blocks");
+                ar.free(c);
+                check(!inner.canRecycle(), "inner scope with its last block live");
+                ar.free(d);
+                check(inner.canRecycle(), "inner scope with all blocks freed");
+                check(outer.canRecycle() == false, "outer scope with b live");
+            }
+            check(ar.used() == used_b, "inner scope rewinds to its start");
+            void* e = ar.alloc(blk);
+            check(static_cast<char*>(e) == static_cast<char*>(b) + blk,
+                  "memory of the inner scope is reused");
+            ar.free(e);
+            ar.free(b);
+        }
+        check(ar.used() == used_a, "outer scope rewinds to its start");
+
+        // A block from before the scope is freed while a block of the
+        // scope is live.  The number of live blocks is the same as at the
+        // start of the scope, but the buffer must not be recycled.
+        {
+            LArena::Scope scope(&ar);
+            void* f = ar.alloc(blk);
+            ar.free(a);
+            check(!scope.canRecycle(), "scope with a live block after an older one is freed");
+            ar.free(f);
+            check(scope.canRecycle(), "scope after all its blocks are freed");
+        }
+        check(ar.used() == used_a, "scope rewinds past the freed older block");
+
+        // reset() must refuse to recycle memory in use
+        void* g = ar.alloc(blk);
+        check(throws([] (LArena& x) { x.reset(); }, ar), "reset with a live block aborts");
+        ar.free(g);
+        check(!throws([] (LArena& x) { x.reset(); }, ar), "reset with no live block");
+        check(ar.used() == 0, "reset rewinds to the start");
+
+        // Freeing a block twice is an error
+        check(throws([] (LArena& x) { void* p = x.alloc(1); x.free(p); x.free(p); }, ar),
+              "double free aborts");
+        ar.reset();
+
+        // Requests that do not fit go to the fallback arena
+        void* big = ar.alloc(128*blk);
+        check(ar.numFallbacks() == 1, "large request falls back");
+        ar.free(big);
+
+        amrex::system::throw_exception = throw_exception;
+
+        if (nfailures == 0) {
+            amrex::Print() << "LArena tests passed\n";
+        }
+        AMREX_ALWAYS_ASSERT(nfailures == 0);
+    }
+    amrex::Finalize();
+}
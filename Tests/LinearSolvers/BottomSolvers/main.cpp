@@ -0,0 +1,142 @@
+//
+// Solve an ABecLaplacian problem with MLMG and the BiCGStab and CG bottom
+// solvers, with and without overlapping their reductions with the
+// applications of the operator (MLMG::setBottomOverlapReduction).
+//
+// Without the overlap, the bottom solvers are the original ones.  With it,
+// BiCGStab must give bitwise the same residual history, bottom iteration
+// counts and solution.  CG is then pipelined, which changes the rounding,
+// so its solution only has to agree to within the solver tolerance, with
+// about the same number of iterations.
+//
+
+#include <AMReX.H>
+#include <AMReX_MLABecLaplacian.H>
+#include <AMReX_MLMG.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <cmath>
+
+using namespace amrex;
+
+namespace {
+
+struct Result
+{
+    Vector<Real> resid;
+    Vector<int>  bottom_iters;
+};
+
+Result solve (MultiFab& sol, MultiFab const& rhs, MultiFab const& acoef,
+              Array<MultiFab,AMREX_SPACEDIM> const& bcoef, Geometry const& geom,
+              BottomSolver bottom_solver, bool overlap)
+{
+    const BoxArray& ba = rhs.boxArray();
+    const DistributionMapping& dm = rhs.DistributionMap();
+
+    // A bottom level with a few boxes and many cells, so that the bottom
+    // solver does many iterations
+    LPInfo info;
+    info.setMaxCoarseningLevel(1);
+
+    MLABecLaplacian mlabec({geom}, {ba}, {dm}, info);
+    mlabec.setDomainBC({AMREX_D_DECL(LinOpBCType::Dirichlet,LinOpBCType::Neumann,LinOpBCType::Dirichlet)},
+                       {AMREX_D_DECL(LinOpBCType::Dirichlet,LinOpBCType::Neumann,LinOpBCType::Dirichlet)});
+    mlabec.setLevelBC(0, nullptr);
+    mlabec.setScalars(1.0, 1.0);
+    mlabec.setACoeffs(0, acoef);
+    mlabec.setBCoeffs(0, amrex::GetArrOfConstPtrs(bcoef));
+
+    MLMG mlmg(mlabec);
+    mlmg.setVerbose(0);
+    mlmg.setBottomVerbose(0);
+    mlmg.setMaxFmgIter(0);
+    mlmg.setBottomSolver(bottom_solver);
+    mlmg.setBottomOverlapReduction(overlap);
+
+    sol.setVal(0.0);
+    mlmg.solve({&sol}, {&rhs}, 1.e-10, 0.0);
+
+    return Result{mlmg.getResidualHistory(), mlmg.getNumCGIters()};
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        const Box domain(IntVect(0), IntVect(n_cell-1));
+        const RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        const Geometry geom(domain, rb, 0, {AMREX_D_DECL(0,0,0)});
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        const DistributionMapping dm(ba);
+
+        MultiFab rhs(ba, dm, 1, 0), acoef(ba, dm, 1, 0);
+        Array<MultiFab,AMREX_SPACEDIM> bcoef;
+        for (int idim = 0; idim < AMREX_SPACEDIM; ++idim) {
+            bcoef[idim].define(amrex::convert(ba,IntVect::TheDimensionVector(idim)), dm, 1, 0);
+            for (MFIter mfi(bcoef[idim]); mfi.isValid(); ++mfi) {
+                auto const& b = bcoef[idim].array(mfi);
+                amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+                {
+                    b(i,j,k) = 1.0 + 0.5*std::sin(0.1*i + 0.2*j + 0.3*k + idim);
+                });
+            }
+        }
+        for (MFIter mfi(rhs); mfi.isValid(); ++mfi) {
+            auto const& r = rhs.array(mfi);
+            auto const& a = acoef.array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+            {
+                r(i,j,k) = std::cos(0.3*i) * std::sin(0.2*j + 0.1*k);
+                a(i,j,k) = 1.0 + 0.1*std::cos(0.05*(i+j+k));
+            });
+        }
+
+        bool ok = true;
+
+        {
+            MultiFab s0(ba, dm, 1, 1), s1(ba, dm, 1, 1);
+            const Result r0 = solve(s0, rhs, acoef, bcoef, geom, BottomSolver::bicgstab, false);
+            const Result r1 = solve(s1, rhs, acoef, bcoef, geom, BottomSolver::bicgstab, true);
+            MultiFab::Subtract(s1, s0, 0, 0, 1, 0);
+            const Real diff = s1.norm0();
+            amrex::Print() << "BiCGStab: " << r0.resid.size() << " MLMG iterations, "
+                           << "max. difference with overlap " << diff << "\n";
+            ok = ok && diff == 0 && r0.resid == r1.resid && r0.bottom_iters == r1.bottom_iters;
+        }
+
+        {
+            MultiFab s0(ba, dm, 1, 1), s1(ba, dm, 1, 1);
+            const Result r0 = solve(s0, rhs, acoef, bcoef, geom, BottomSolver::cg, false);
+            const Result r1 = solve(s1, rhs, acoef, bcoef, geom, BottomSolver::cg, true);
+            const Real snorm = s0.norm0();
+            MultiFab::Subtract(s1, s0, 0, 0, 1, 0);
+            const Real diff = s1.norm0();
+            int it0 = 0, it1 = 0;
+            for (int it : r0.bottom_iters) { it0 += it; }
+            for (int it : r1.bottom_iters) { it1 += it; }
+            amrex::Print() << "CG: " << r0.resid.size() << " and " << r1.resid.size()
+                           << " MLMG iterations, " << it0 << " and " << it1
+                           << " bottom iterations, relative difference with overlap "
+                           << diff/snorm << "\n";
+            ok = ok && diff <= 1.e-8*snorm && std::abs(it1-it0) <= it0/10 + r0.bottom_iters.size()
+                && r0.resid.size() == r1.resid.size();
+        }
+
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(ok, "results with overlapped reductions differ");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,302 @@
+//
+// Check the distribution mapping strategies and the work-stealing MFIter
+// on random BoxArrays with random costs.
+//
+// Every mapping must assign each box to exactly one process, the same on
+// all processes.  The multi-constraint knapsack must balance the worst of
+// its constraints at least as well as the plain knapsack of the summed
+// costs, and a single constraint as well as the plain knapsack.  The
+// incremental rebalancing must not lower the efficiency of the mapping it
+// starts from, e.g., a knapsack mapping of the same costs.  Without a
+// migration budget it must return the current mapping.  A work-stealing
+// MFIter loop must visit every tile exactly once, with and without the
+// Hilbert order of the tiles.
+//
+
+#include <AMReX.H>
+#include <AMReX_DistributionMapping.H>
+#include <AMReX_iMultiFab.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <random>
+
+using namespace amrex;
+
+namespace {
+
+std::mt19937 gen(7);
+
+int rand_int (int lo, int hi)
+{
+    std::uniform_int_distribution<int> dist(lo, hi);
+    return dist(gen);
+}
+
+// Chop the domain into boxes of random sizes and drop some of them.
+BoxArray rand_boxarray (const Box& domain, int max_grid_size)
+{
+    BoxList chopped(domain);
+    chopped.maxSize(rand_int(2, max_grid_size));
+    BoxList bl;
+    std::uniform_real_distribution<Real> dist(0., 1.);
+    const Real keep = rand_int(5,10)/Real(10.);
+    for (auto const& b : chopped) {
+        if (dist(gen) < keep) {
+            Box bx = b;
+            if (dist(gen) < 0.3) {
+                int d = rand_int(0, AMREX_SPACEDIM-1);
+                bx.setBig(d, bx.smallEnd(d) + rand_int(0, bx.length(d)-1));
+            }
+            bl.push_back(bx);
+        }
+    }
+    if (bl.isEmpty()) bl.push_back(domain);
+    return BoxArray(std::move(bl));
+}
+
+// Costs that vary over two orders of magnitude
+Vector<Real> rand_costs (int n)
+{
+    std::lognormal_distribution<Real> dist(0., 1.5);
+    Vector<Real> c(n);
+    for (auto& x : c) x = dist(gen);
+    return c;
+}
+
+// The plain knapsack rounds the costs to integers, in units of 1.e-9 of
+// the largest cost, so its loads can be off by that much per box.
+Real tolerance (int nboxes)
+{
+    return 1.e-9*nboxes;
+}
+
+int nfail = 0;
+
+void fail (const std::string& what)
+{
+    ++nfail;
+    amrex::Print() << "  " << what << "\n";
+}
+
+// Is every box on exactly one process, the same on all processes?
+void check_owners (const DistributionMapping& dm, const BoxArray& ba, const std::string& what)
+{
+    const int N = ba.size();
+    const int nprocs = ParallelDescriptor::NProcs();
+    if (static_cast<int>(dm.size()) != N) {
+        fail(what + ": wrong number of boxes");
+        return;
+    }
+
+    Vector<int> pmap = dm.ProcessorMap();
+    Vector<int> pmap0 = pmap;
+    ParallelDescriptor::Bcast(pmap0.data(), N, 0);
+    int bad = (pmap != pmap0);
+    for (int p : pmap) {
+        if (p < 0 || p >= nprocs) bad = 1;
+    }
+    ParallelDescriptor::ReduceIntMax(bad);
+    if (bad) {
+        fail(what + ": the processes differ");
+        return;
+    }
+
+    // Count the owners of each box from the local boxes of every process.
+    iMultiFab mf(ba, dm, 1, 0, MFInfo().SetAlloc(false));
+    Vector<int> count(N, 0);
+    for (int i : mf.IndexArray()) {
+        ++count[i];
+    }
+    ParallelDescriptor::ReduceIntSum(count.data(), N);
+    if (std::any_of(count.begin(), count.end(), [] (int c) { return c != 1; })) {
+        fail(what + ": a box does not have exactly one owner");
+    }
+}
+
+Real min_efficiency (const DistributionMapping& dm, const Vector<Vector<Real> >& costs)
+{
+    Vector<Real> eff;
+    DistributionMapping::ComputeDistributionMappingEfficiency(dm, costs, eff);
+    return *std::min_element(eff.begin(), eff.end());
+}
+
+void check_mappings (const BoxArray& ba, const std::string& name)
+{
+    const int N = ba.size();
+    const Vector<Real> c0 = rand_costs(N);
+    const Vector<Real> c1 = rand_costs(N);
+
+    Real eff;
+    const DistributionMapping dm_ks = DistributionMapping::makeKnapSack(c0, eff);
+    check_owners(dm_ks, ba, name + " KNAPSACK");
+    check_owners(DistributionMapping::makeSFC(c0, ba, eff), ba, name + " SFC");
+    check_owners(DistributionMapping::makeNodeSFC(c0, ba, eff), ba, name + " NODESFC");
+    {
+        const auto strategy = DistributionMapping::strategy();
+        DistributionMapping::strategy(DistributionMapping::HILBERT);
+        check_owners(DistributionMapping::makeSFC(c0, ba, eff), ba, name + " HILBERT");
+        DistributionMapping::strategy(strategy);
+    }
+
+    // Two constraints, scaled alike, against the knapsack of their sum
+    {
+        Real s0 = 0., s1 = 0.;
+        for (int i = 0; i < N; ++i) {
+            s0 += c0[i];
+            s1 += c1[i];
+        }
+        const Vector<Vector<Real> > costs{c0, c1};
+        Vector<Real> sum(N);
+        for (int i = 0; i < N; ++i) {
+            sum[i] = c0[i]/s0 + c1[i]/s1;
+        }
+
+        Vector<Real> effs;
+        const DistributionMapping dm_mc = DistributionMapping::makeKnapSack(costs, effs);
+        check_owners(dm_mc, ba, name + " multi-constraint KNAPSACK");
+        check_owners(DistributionMapping::makeSFC(costs, ba, effs), ba,
+                     name + " multi-constraint SFC");
+
+        const DistributionMapping dm_sum = DistributionMapping::makeKnapSack(sum, eff);
+        const Real e_mc = min_efficiency(dm_mc, costs);
+        const Real e_sum = min_efficiency(dm_sum, costs);
+        if (e_mc < e_sum*(1.-tolerance(N))) {
+            fail(name + ": multi-constraint KNAPSACK efficiency " + std::to_string(e_mc)
+                 + " < " + std::to_string(e_sum));
+        }
+
+        // One constraint
+        const DistributionMapping dm_one = DistributionMapping::makeKnapSack({c0}, effs);
+        const Real e_one = min_efficiency(dm_one, {c0});
+        const Real e_ks = min_efficiency(dm_ks, {c0});
+        if (e_one < e_ks*(1.-tolerance(N))) {
+            fail(name + ": one-constraint KNAPSACK efficiency " + std::to_string(e_one)
+                 + " < " + std::to_string(e_ks));
+        }
+    }
+
+    // Incremental rebalancing of the knapsack mapping of other costs
+    {
+        Vector<Long> bytes(N);
+        Long total = 0;
+        for (int i = 0; i < N; ++i) {
+            bytes[i] = ba[i].numPts()*8;
+            total += bytes[i];
+        }
+
+        Real e_cur, e_new;
+        Long moved;
+        const DistributionMapping dm_inc = DistributionMapping::makeIncremental(
+            dm_ks, c1, bytes, total/10, e_cur, e_new, moved);
+        check_owners(dm_inc, ba, name + " incremental");
+        if (e_new < e_cur) {
+            fail(name + ": incremental efficiency went down");
+        }
+        if (moved > total/10) {
+            fail(name + ": incremental moved more than its budget");
+        }
+
+        const DistributionMapping dm_ks1 = DistributionMapping::makeKnapSack(c1, eff);
+        const DistributionMapping dm_inc1 = DistributionMapping::makeIncremental(
+            dm_ks1, c1, bytes, total, e_cur, e_new, moved);
+        if (e_new < e_cur) {
+            fail(name + ": incremental efficiency is below KNAPSACK");
+        }
+
+        const DistributionMapping dm_same = DistributionMapping::makeIncremental(
+            dm_ks, c1, bytes, 0, e_cur, e_new, moved);
+        if (dm_same.ProcessorMap() != dm_ks.ProcessorMap() || moved != 0 || e_new != e_cur) {
+            fail(name + ": incremental without a budget changed the mapping");
+        }
+    }
+}
+
+// Does a work-stealing MFIter loop visit every tile once?
+void check_tiles (const BoxArray& ba, const IntVect& tile_size, const std::string& name)
+{
+    const DistributionMapping dm(ba);
+    iMultiFab cells(ba, dm, 1, 0);
+    cells.setVal(0);
+
+    int ntiles = 0;
+    for (MFIter mfi(cells, tile_size); mfi.isValid(); ++mfi) {
+        ntiles = std::max(ntiles, mfi.tileIndex()+1);
+    }
+    Vector<int> visits(ntiles, 0);
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(cells, MFItInfo().EnableTiling(tile_size).SetWorkStealing(true));
+         mfi.isValid(); ++mfi)
+    {
+#ifdef AMREX_USE_OMP
+#pragma omp atomic
+#endif
+        ++visits[mfi.tileIndex()];
+        auto const& a = cells.array(mfi);
+        amrex::LoopOnCpu(mfi.tilebox(), [=] (int i, int j, int k) { a(i,j,k) += 1; });
+    }
+
+    int bad = std::any_of(visits.begin(), visits.end(), [] (int v) { return v != 1; });
+    bad = bad || cells.min(0) != 1 || cells.max(0) != 1;
+    ParallelDescriptor::ReduceIntMax(bad);
+    if (bad) {
+        fail(name + ": the work-stealing MFIter did not visit every tile once");
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int ntrials = 50;
+        int n_cell = 64;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("ntrials", ntrials);
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        const bool sfc_tiles_save = FabArrayBase::mfiter_sfc_tiles;
+
+        const Box domain(IntVect(0), IntVect(n_cell-1));
+
+        for (int trial = 0; trial < ntrials; ++trial)
+        {
+            // Every process must use the same random numbers.
+            const BoxArray ba = rand_boxarray(domain, max_grid_size);
+            const std::string name = "trial " + std::to_string(trial);
+
+            const int nfail_save = nfail;
+
+            check_mappings(ba, name);
+
+            IntVect tile_size;
+            for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+                tile_size[d] = rand_int(1, max_grid_size);
+            }
+            FabArrayBase::mfiter_sfc_tiles = (trial % 2 == 1);
+            FabArrayBase::flushTileArrayCache();
+            check_tiles(ba, tile_size, name);
+
+            if (nfail > nfail_save) {
+                amrex::Print() << name << " with " << ba.size() << " boxes failed\n";
+            }
+        }
+
+        FabArrayBase::mfiter_sfc_tiles = sfc_tiles_save;
+        FabArrayBase::flushTileArrayCache();
+
+        amrex::Print() << nfail << " failed checks\n";
+        AMREX_ALWAYS_ASSERT(nfail == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,175 @@
+//
+// Compare the MFExpr statements with MultiFab::Saxpy, LinComb and
+// Multiply, including ghost cells, and the MFExpr reductions with
+// MultiFab::Dot, norm0, norm1, norm2, min and max, for single components
+// and for several components at once.  Mixed sums, minima and maxima are
+// also done together in one Run.
+//
+// The data are multiples of 1/4 of the order of one, so that all the
+// products and sums are exact in any order and the results must be
+// bitwise equal.  The ghost cells have data too, so that a reduction that
+// included them would give a different result.
+//
+
+#include <AMReX.H>
+#include <AMReX_MFExpr.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <algorithm>
+#include <cmath>
+
+using namespace amrex;
+
+namespace {
+
+constexpr int ncomp = 3;
+constexpr int ng = 2;
+
+void init (MultiFab& mf, int a, int b, int c)
+{
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        auto const& x = mf.array(mfi);
+        amrex::LoopOnCpu(mfi.fabbox(), ncomp, [=] (int i, int j, int k, int n) {
+            x(i,j,k,n) = Real(((a*i + b*j + c*k + 11*n) % 17 + 17) % 17 - 8) * 0.25;
+        });
+    }
+}
+
+int nfail = 0;
+
+void check (Real result, Real expected, char const* what)
+{
+    if (result != expected) {
+        ++nfail;
+        amrex::Print() << what << " is " << result << ", expected " << expected << "\n";
+    }
+}
+
+void check (const MultiFab& result, const MultiFab& expected, int nghost, char const* what)
+{
+    Long ndiff = 0;
+    for (MFIter mfi(result); mfi.isValid(); ++mfi) {
+        auto const& a = result.const_array(mfi);
+        auto const& b = expected.const_array(mfi);
+        amrex::LoopOnCpu(amrex::grow(mfi.validbox(),nghost), ncomp, [&] (int i, int j, int k, int n) {
+            if (a(i,j,k,n) != b(i,j,k,n)) ++ndiff;
+        });
+    }
+    ParallelDescriptor::ReduceLongSum(ndiff);
+    if (ndiff > 0) {
+        ++nfail;
+        amrex::Print() << what << ": " << ndiff << " cells differ\n";
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        using namespace amrex::MFExpr;
+
+        int n_cell = 32;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        BoxArray ba(Box(IntVect(0), IntVect(n_cell-1)));
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab x(ba, dm, ncomp, ng), y(ba, dm, ncomp, ng);
+        init(x, 7, 3, 5);
+        init(y, 2, 13, 9);
+
+        const Real a = 1.5;
+        const Real b = -0.25;
+
+        // Statements
+        {
+            MultiFab d0(ba, dm, ncomp, ng), d1(ba, dm, ncomp, ng);
+
+            init(d0, 1, 1, 1);
+            init(d1, 1, 1, 1);
+            MultiFab::Saxpy(d0, a, x, 0, 0, ncomp, ng);
+            Assign(d1, Ref(d1) + a*Ref(x), 0, ncomp, IntVect(ng));
+            check(d1, d0, ng, "Assign of Saxpy");
+
+            MultiFab::LinComb(d0, a, x, 0, b, y, 0, 0, ncomp, ng);
+            Assign(d1, a*Ref(x) + b*Ref(y), 0, ncomp, IntVect(ng));
+            check(d1, d0, ng, "Assign of LinComb");
+
+            // One component of x into the next of d, with ghost cells
+            MultiFab::LinComb(d0, a, x, 0, b, y, 1, 1, 1, 1);
+            Assign(d1, a*Ref(x,0) + b*Ref(y,1), 1, 1, IntVect(1));
+            check(d1, d0, ng, "Assign of a LinComb of one component");
+
+            // d = a*x + b*y; d += a*x, then the dot product of d and x
+            MultiFab::LinComb(d0, a, x, 0, b, y, 0, 0, ncomp, 0);
+            MultiFab::Saxpy(d0, a, x, 0, 0, ncomp, 0);
+            const Real dot0 = MultiFab::Dot(d0, 0, x, 0, ncomp, 0);
+            auto r = Run(Fuse(Set(d1, a*Ref(x) + b*Ref(y), 0, ncomp),
+                              Set(d1, Ref(d1) + a*Ref(x), 0, ncomp)),
+                         Sum(Ref(d1)*Ref(x)));
+            check(d1, d0, ng, "Fuse of LinComb and Saxpy");
+            check(r[0], dot0, "Dot of the Fuse");
+
+            MultiFab::Copy(d0, x, 0, 0, ncomp, ng);
+            MultiFab::Multiply(d0, y, 0, 0, ncomp, ng);
+            Run(Fuse(Set(d1, Ref(x)*Ref(y), 0, ncomp)));
+            check(d1, d0, 0, "Fuse of Multiply");
+        }
+
+        // Reductions of one component
+        for (int n = 0; n < ncomp; ++n) {
+            check(Dot(Ref(x,n), Ref(y,n)), MultiFab::Dot(x, n, y, n, 1, 0), "Dot");
+            check(Norm0(Ref(x,n)), x.norm0(n), "Norm0");
+            check(Norm1(Ref(x,n)), x.norm1(n), "Norm1");
+            check(Norm2(Ref(x,n)), x.norm2(n), "Norm2");
+            check(Norm2(Ref(x,n) - Ref(y,n)), std::sqrt(MultiFab::Dot(x, n, 1, 0)
+                                                        - 2.*MultiFab::Dot(x, n, y, n, 1, 0)
+                                                        + MultiFab::Dot(y, n, 1, 0)),
+                  "Norm2 of a difference");
+
+            auto r = Run(Sum(Ref(x,n)*Ref(y,n)), Min(Ref(y,n)), Max(abs(Ref(x,n))),
+                         Sum(abs(Ref(x,n))), Max(Ref(y,n)));
+            check(r[0], MultiFab::Dot(x, n, y, n, 1, 0), "Mixed Sum");
+            check(r[1], y.min(n), "Mixed Min");
+            check(r[2], x.norm0(n), "Mixed Max of abs");
+            check(r[3], x.norm1(n), "Mixed Sum of abs");
+            check(r[4], y.max(n), "Mixed Max");
+        }
+
+        // Reductions of all the components together
+        {
+            MultiFab z(ba, dm, ncomp, 0);
+            Real norm0 = 0.;
+            Real norm1 = 0.;
+            Real ymin = y.min(0);
+            for (int n = 0; n < ncomp; ++n) {
+                norm0 = std::max(norm0, x.norm0(n));
+                norm1 += x.norm1(n);
+                ymin = std::min(ymin, y.min(n));
+            }
+            auto r = Run(Fuse(Set(z, Ref(x) - Ref(y), 0, ncomp)),
+                         Sum(Ref(x)*Ref(y)), Max(abs(Ref(x))), Sum(abs(Ref(x))), Min(Ref(y)),
+                         Sum(Ref(z)*Ref(z)));
+            check(r[0], MultiFab::Dot(x, 0, y, 0, ncomp, 0), "Sum over components");
+            check(r[1], norm0, "Max over components");
+            check(r[2], norm1, "Sum of abs over components");
+            check(r[3], ymin, "Min over components");
+            check(r[4], MultiFab::Dot(z, 0, ncomp, 0), "Sum of the new values");
+        }
+
+        ParallelDescriptor::ReduceIntMax(nfail);
+        amrex::Print() << nfail << " wrong results\n";
+        AMREX_ALWAYS_ASSERT(nfail == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,246 @@
+//
+// Run a few iterations of FillBoundary -> stencil -> reductions -> update
+// with MFTaskGraph, once with a graph per iteration and once with all the
+// iterations in one graph, and compare the data and the reductions with
+// the same iterations done with plain MFIter loops.  The results must be
+// bitwise equal, with any number of processes and threads, because the
+// graph combines the tiles of a reduction in MFIter order.
+//
+// In every iteration, the ghost cells of phi are read twice without a
+// write in between, so there must be only one FillBoundary per iteration.
+//
+
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MFTaskGraph.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParallelContext.H>
+#include <AMReX_ParallelReduce.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <cmath>
+#include <limits>
+
+using namespace amrex;
+
+namespace {
+
+constexpr int ncomp = 2;
+constexpr Real dt = 0.1;
+
+void init (MultiFab& phi, const Geometry& geom)
+{
+    const auto dx = geom.CellSizeArray();
+    for (MFIter mfi(phi); mfi.isValid(); ++mfi) {
+        auto const& a = phi.array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), ncomp, [=] (int i, int j, int k, int n) {
+            a(i,j,k,n) = std::sin((n+1)*i*dx[0]) * std::cos(j*dx[1]+n) * std::exp(-k*dx[2]);
+        });
+    }
+}
+
+void stencil (const MultiFab& phi, MultiFab& rhs, const Box& bx, int K)
+{
+    auto const& p = phi.const_array(K);
+    auto const& r = rhs.array(K);
+    amrex::LoopOnCpu(bx, ncomp, [=] (int i, int j, int k, int n) {
+        r(i,j,k,n) = -6.*p(i,j,k,n)
+            + p(i-1,j,k,n) + p(i+1,j,k,n)
+            + p(i,j-1,k,n) + p(i,j+1,k,n)
+            + p(i,j,k-1,n) + p(i,j,k+1,n);
+    });
+}
+
+void update (MultiFab& phi, const MultiFab& rhs, const Box& bx, int K)
+{
+    auto const& p = phi.array(K);
+    auto const& r = rhs.const_array(K);
+    amrex::LoopOnCpu(bx, ncomp, [=] (int i, int j, int k, int n) {
+        p(i,j,k,n) += dt*r(i,j,k,n);
+    });
+}
+
+Real tile_sum (const MultiFab& mf, const Box& bx, int K)
+{
+    auto const& a = mf.const_array(K);
+    Real s = 0.;
+    amrex::LoopOnCpu(bx, ncomp, [&] (int i, int j, int k, int n) { s += a(i,j,k,n); });
+    return s;
+}
+
+Real tile_max (const MultiFab& mf, const Box& bx, int K)
+{
+    auto const& a = mf.const_array(K);
+    Real m = std::numeric_limits<Real>::lowest();
+    amrex::LoopOnCpu(bx, ncomp, [&] (int i, int j, int k, int n) {
+        m = std::max(m, std::abs(a(i,j,k,n)));
+    });
+    return m;
+}
+
+void iterate_mfiter (MultiFab& phi, MultiFab& rhs, const Geometry& geom,
+                     Real& sum, Real& max)
+{
+    phi.FillBoundary(geom.periodicity());
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(rhs,true); mfi.isValid(); ++mfi) {
+        stencil(phi, rhs, mfi.tilebox(), mfi.index());
+    }
+
+    sum = 0.;
+    for (MFIter mfi(rhs,true); mfi.isValid(); ++mfi) {
+        sum += tile_sum(rhs, mfi.tilebox(), mfi.index());
+    }
+    ParallelAllReduce::Sum(sum, ParallelContext::CommunicatorSub());
+
+    max = std::numeric_limits<Real>::lowest();
+    for (MFIter mfi(phi,true); mfi.isValid(); ++mfi) {
+        max = std::max(max, tile_max(phi, mfi.growntilebox(1), mfi.index()));
+    }
+    ParallelAllReduce::Max(max, ParallelContext::CommunicatorSub());
+
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(phi,true); mfi.isValid(); ++mfi) {
+        update(phi, rhs, mfi.tilebox(), mfi.index());
+    }
+}
+
+void add_iteration (MFTaskGraph& g, MultiFab& phi, MultiFab& rhs, const Geometry& geom,
+                    Real& sum, Real& max)
+{
+    const Periodicity period = geom.periodicity();
+
+    g.addLoop({MFTaskGraph::In(phi, IntVect(1), period), MFTaskGraph::Out(rhs)},
+              [&phi,&rhs] (MFTaskGraph::Tile const& t) {
+                  stencil(phi, rhs, t.tilebox(), t.index());
+              });
+
+    g.addReduction({MFTaskGraph::In(rhs)}, MFTaskGraph::ReduceType::sum,
+                   [&rhs] (MFTaskGraph::Tile const& t) {
+                       return tile_sum(rhs, t.tilebox(), t.index());
+                   }, sum);
+
+    g.addReduction({MFTaskGraph::In(phi, IntVect(1), period)}, MFTaskGraph::ReduceType::max,
+                   [&phi] (MFTaskGraph::Tile const& t) {
+                       return tile_max(phi, t.growntilebox(IntVect(1)), t.index());
+                   }, max);
+
+    g.addLoop({MFTaskGraph::InOut(phi), MFTaskGraph::In(rhs)},
+              [&phi,&rhs] (MFTaskGraph::Tile const& t) {
+                  update(phi, rhs, t.tilebox(), t.index());
+              });
+}
+
+int nfail = 0;
+
+void check (Real result, Real expected, char const* what, int it)
+{
+    if (result != expected) {
+        ++nfail;
+        amrex::Print() << what << " of iteration " << it << " is " << result
+                       << ", expected " << expected << "\n";
+    }
+}
+
+void check (const MultiFab& result, const MultiFab& expected, char const* what)
+{
+    Long ndiff = 0;
+    for (MFIter mfi(result); mfi.isValid(); ++mfi) {
+        auto const& a = result.const_array(mfi);
+        auto const& b = expected.const_array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), ncomp, [&] (int i, int j, int k, int n) {
+            if (a(i,j,k,n) != b(i,j,k,n)) ++ndiff;
+        });
+    }
+    ParallelDescriptor::ReduceLongSum(ndiff);
+    if (ndiff > 0) {
+        ++nfail;
+        amrex::Print() << what << ": " << ndiff << " cells differ\n";
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 16;
+        int niter = 4;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("niter", niter);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, rb, CoordSys::cartesian, is_periodic);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        MultiFab phi0(ba, dm, ncomp, 1), rhs0(ba, dm, ncomp, 0);
+        MultiFab phi1(ba, dm, ncomp, 1), rhs1(ba, dm, ncomp, 0);
+        MultiFab phi2(ba, dm, ncomp, 1), rhs2(ba, dm, ncomp, 0);
+        init(phi0, geom);
+        init(phi1, geom);
+        init(phi2, geom);
+
+        Vector<Real> sum0(niter), max0(niter);
+        Vector<Real> sum1(niter), max1(niter);
+        Vector<Real> sum2(niter), max2(niter);
+
+        for (int it = 0; it < niter; ++it) {
+            iterate_mfiter(phi0, rhs0, geom, sum0[it], max0[it]);
+        }
+
+        for (int it = 0; it < niter; ++it) {
+            MFTaskGraph g;
+            add_iteration(g, phi1, rhs1, geom, sum1[it], max1[it]);
+            g.execute();
+            if (g.numFillBoundary() != 1) {
+                ++nfail;
+                amrex::Print() << "Graph of iteration " << it << " has "
+                               << g.numFillBoundary() << " FillBoundary calls\n";
+            }
+        }
+
+        {
+            MFTaskGraph g;
+            for (int it = 0; it < niter; ++it) {
+                add_iteration(g, phi2, rhs2, geom, sum2[it], max2[it]);
+            }
+            if (g.numFillBoundary() != niter) {
+                ++nfail;
+                amrex::Print() << "Graph of " << niter << " iterations has "
+                               << g.numFillBoundary() << " FillBoundary calls\n";
+            }
+            g.execute();
+        }
+
+        for (int it = 0; it < niter; ++it) {
+            check(sum1[it], sum0[it], "Sum of one-iteration graph", it);
+            check(max1[it], max0[it], "Max of one-iteration graph", it);
+            check(sum2[it], sum0[it], "Sum of all-iteration graph", it);
+            check(max2[it], max0[it], "Max of all-iteration graph", it);
+        }
+        check(phi1, phi0, "phi of one-iteration graphs");
+        check(rhs1, rhs0, "rhs of one-iteration graphs");
+        check(phi2, phi0, "phi of all-iteration graph");
+        check(rhs2, rhs0, "rhs of all-iteration graph");
+
+        amrex::Print() << nfail << " wrong results\n";
+        AMREX_ALWAYS_ASSERT(nfail == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,171 @@
+//
+// Compare three SSP-RK3 stages of the heat equation done one after the
+// other, with a FillBoundary and a sweep over the MultiFab per stage, with
+// the same stages fused per tile by MultiStageStencil.
+//
+// The bytes per cell are those of the arrays each version streams through
+// memory: every unfused stage reads its inputs and writes its output, and
+// the fused stages read the input (with the ghost zones of the tile) and
+// write the output once.  The results must agree exactly, because the
+// cells of the overlapping ghost zones are computed the same way as on the
+// neighboring tiles.
+//
+
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_MultiStageStencil.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+#include <cmath>
+#include <iomanip>
+
+using namespace amrex;
+
+namespace {
+
+// out = a*u + b*(prev + dt*lap(prev))
+void rk_stage (Box const& bx, Array4<Real const> const& u, Array4<Real const> const& prev,
+               Array4<Real> const& out, Real a, Real b, Real dt)
+{
+    amrex::LoopOnCpu(bx, [=] (int i, int j, int k) noexcept
+    {
+        Real lap = AMREX_D_TERM(prev(i-1,j,k) + prev(i+1,j,k),
+                              + prev(i,j-1,k) + prev(i,j+1,k),
+                              + prev(i,j,k-1) + prev(i,j,k+1))
+            - Real(2*AMREX_SPACEDIM)*prev(i,j,k);
+        out(i,j,k) = a*u(i,j,k) + b*(prev(i,j,k) + dt*lap);
+    });
+}
+
+const Real rk_a[3] = {0., 0.75, 1./3.};
+const Real rk_b[3] = {1., 0.25, 2./3.};
+
+void report (const std::string& name, double t, Long ncells, int nsteps, Real bytes_per_cell)
+{
+    const double tcell = t / (static_cast<double>(ncells)*nsteps);
+    amrex::Print() << std::setw(10) << name
+                   << std::setw(14) << t
+                   << std::setw(14) << tcell*1.e9
+                   << std::setw(14) << bytes_per_cell
+                   << std::setw(14) << bytes_per_cell/tcell*1.e-9 << "\n";
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 128;
+        int max_grid_size = 64;
+        int nsteps = 10;
+        Long cache_bytes = 1024*1024;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nsteps", nsteps);
+            pp.query("cache_bytes", cache_bytes);
+        }
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, rb, CoordSys::cartesian, is_periodic);
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        const Real dt = 0.1;
+
+        MultiStageStencil ms(cache_bytes);
+        for (int s = 0; s < 3; ++s) {
+            const Real a = rk_a[s], b = rk_b[s];
+            ms.addStage(IntVect(1), 1,
+                        [=] (Box const& bx, Array4<Real const> const& u,
+                             Array4<Real const> const& prev, Array4<Real> const& out)
+                        { rk_stage(bx, u, prev, out, a, b, dt); });
+        }
+
+        MultiFab u0(ba, dm, 1, ms.nGrow());
+        for (MFIter mfi(u0); mfi.isValid(); ++mfi) {
+            auto const& u = u0.array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+            {
+                u(i,j,k) = std::sin(0.1*i) AMREX_D_TERM(, + std::cos(0.2*j), + std::sin(0.3*k));
+            });
+        }
+
+        //
+        // One sweep and one FillBoundary per stage
+        //
+        MultiFab u(ba, dm, 1, 1), u1(ba, dm, 1, 1), u2(ba, dm, 1, 1);
+        MultiFab::Copy(u, u0, 0, 0, 1, 0);
+        double t_unfused = amrex::second();
+        for (int step = 0; step < nsteps; ++step)
+        {
+            MultiFab* prev = &u;
+            MultiFab* stage_out[3] = {&u1, &u2, &u1};
+            for (int s = 0; s < 3; ++s) {
+                prev->FillBoundary(geom.periodicity());
+                MultiFab& out = *stage_out[s];
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+                for (MFIter mfi(out, true); mfi.isValid(); ++mfi) {
+                    rk_stage(mfi.tilebox(), u.const_array(mfi), prev->const_array(mfi),
+                             out.array(mfi), rk_a[s], rk_b[s], dt);
+                }
+                prev = &out;
+            }
+            MultiFab::Copy(u, u1, 0, 0, 1, 0);
+        }
+        t_unfused = amrex::second() - t_unfused;
+
+        //
+        // Fused stages
+        //
+        MultiFab uf(ba, dm, 1, ms.nGrow()), unew(ba, dm, 1, 0);
+        MultiFab::Copy(uf, u0, 0, 0, 1, 0);
+        double t_fused = amrex::second();
+        for (int step = 0; step < nsteps; ++step) {
+            ms.run(uf, unew, geom.periodicity());
+            MultiFab::Copy(uf, unew, 0, 0, 1, 0);
+        }
+        t_fused = amrex::second() - t_fused;
+
+        //
+        // Bytes streamed per cell and step.  Stage 0 reads u and writes u1,
+        // stages 1 and 2 read u and the previous stage and write their
+        // output.  The fused stages read u with the ghost zones of the
+        // tiles and write unew.  Both copy the result back into u.
+        //
+        const Real word = sizeof(Real);
+        const Real copy_bytes = 2*word;
+        const Real unfused_bytes = (2 + 3 + 3)*word + copy_bytes;
+        const IntVect ts = ms.tileSize(ba, 1);
+        const Real ghost_ratio = Real(amrex::grow(Box(IntVect(0), ts-1), ms.nGrow()).numPts())
+            / Real(Box(IntVect(0), ts-1).numPts());
+        const Real fused_bytes = (ghost_ratio + 1)*word + copy_bytes;
+
+        MultiFab::Subtract(u, uf, 0, 0, 1, 0);
+        const Real diff = u.norm0();
+
+        amrex::Print() << "\n" << ba.size() << " boxes of up to " << max_grid_size << "^"
+                       << AMREX_SPACEDIM << " cells, " << nsteps << " steps of 3 stages\n"
+                       << "fused tile size " << ts << ", working set " << ms.workingSet(ts,1)
+                       << " bytes, " << ms.redundancy() << " cells computed per cell\n\n"
+                       << std::setw(10) << " " << std::setw(14) << "time"
+                       << std::setw(14) << "ns/cell" << std::setw(14) << "bytes/cell"
+                       << std::setw(14) << "GB/s" << "\n";
+        report("unfused", t_unfused, ba.numPts(), nsteps, unfused_bytes);
+        report("fused", t_fused, ba.numPts(), nsteps, fused_bytes);
+        amrex::Print() << "\nmax difference " << diff << "\n";
+
+        AMREX_ALWAYS_ASSERT(diff == 0.);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,140 @@
+//
+// Run FillBoundary with persistent requests (fabarray.use_persistent_fb)
+// side by side with ordinary FillBoundary and ParallelCopy calls, and
+// compare the results, ghost cells included, with those of ordinary calls
+// only.
+//
+// The range of MPI tags is cut down, so that ParallelDescriptor::SeqNum()
+// wraps around every few calls, and the ordinary messages get the tags
+// that the persistent requests were set up with.  One box is far from the
+// others, so that the process it is on may have nothing to exchange.
+//
+
+#include <AMReX.H>
+#include <AMReX_Geometry.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+
+#include <cmath>
+
+using namespace amrex;
+
+namespace {
+
+void init (MultiFab& mf, int step, Real id)
+{
+    mf.setVal(-1.e30);
+    for (MFIter mfi(mf); mfi.isValid(); ++mfi) {
+        auto const& a = mf.array(mfi);
+        amrex::LoopOnCpu(mfi.validbox(), mf.nComp(), [=] (int i, int j, int k, int n) noexcept
+        {
+            a(i,j,k,n) = id + step + std::sin(Real(0.1)*(i + 2*j + 3*k) + n);
+        });
+    }
+}
+
+Real maxdiff (MultiFab const& a, MultiFab const& b)
+{
+    Real r = 0.;
+    for (MFIter mfi(a); mfi.isValid(); ++mfi) {
+        auto const& x = a.const_array(mfi);
+        auto const& y = b.const_array(mfi);
+        amrex::LoopOnCpu(mfi.fabbox(), a.nComp(), [&] (int i, int j, int k, int n) noexcept
+        {
+            r = std::max(r, std::abs(x(i,j,k,n) - y(i,j,k,n)));
+        });
+    }
+    ParallelDescriptor::ReduceRealMax(r);
+    return r;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 32;
+        int max_grid_size = 8;
+        int nsteps = 20;
+        int ntags = 3;
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("max_grid_size", max_grid_size);
+            pp.query("nsteps", nsteps);
+            pp.query("ntags", ntags);
+        }
+
+        const int max_tag = ParallelDescriptor::m_MaxTag;
+        ParallelDescriptor::m_MaxTag = ParallelDescriptor::m_MinTag + ntags - 1;
+        const bool use_persistent_fb = FabArrayBase::use_persistent_fb;
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        RealBox rb({AMREX_D_DECL(0.,0.,0.)}, {AMREX_D_DECL(1.,1.,1.)});
+        Array<int,AMREX_SPACEDIM> is_periodic{AMREX_D_DECL(1,1,1)};
+        Geometry geom(domain, rb, CoordSys::cartesian, is_periodic);
+
+        BoxArray ba(domain);
+        ba.maxSize(max_grid_size);
+        DistributionMapping dm(ba);
+
+        BoxArray ba2(domain);
+        ba2.maxSize(max_grid_size/2);
+        DistributionMapping dm2(ba2);
+
+        // Two boxes next to each other and one far away, not periodic
+        Box b0(IntVect(0), IntVect(7));
+        BoxArray ba3(BoxList(Vector<Box>{b0, b0+IntVect(AMREX_D_DECL(8,0,0)),
+                                         b0+IntVect(AMREX_D_DECL(40,40,40))}));
+        Vector<int> pmap3{0, std::min(1, ParallelDescriptor::NProcs()-1),
+                          std::min(2, ParallelDescriptor::NProcs()-1)};
+        DistributionMapping dm3(pmap3);
+
+        const int ng = 2;
+        MultiFab a(ba, dm, 2, ng), aref(ba, dm, 2, ng);
+        MultiFab b(ba, dm, 2, ng), bref(ba, dm, 2, ng);
+        MultiFab c(ba2, dm2, 2, ng), cref(ba2, dm2, 2, ng);
+        MultiFab s(ba3, dm3, 1, ng), sref(ba3, dm3, 1, ng);
+
+        Real diff = 0.;
+        for (int step = 0; step < nsteps; ++step)
+        {
+            for (MultiFab* mf : {&a, &aref}) init(*mf, step, 100.);
+            for (MultiFab* mf : {&b, &bref}) init(*mf, step, 200.);
+            for (MultiFab* mf : {&c, &cref}) init(*mf, step, 300.);
+            for (MultiFab* mf : {&s, &sref}) init(*mf, step, 400.);
+
+            // Persistent requests in flight while other messages are exchanged
+            FabArrayBase::use_persistent_fb = true;
+            a.FillBoundary_nowait(geom.periodicity());
+            s.FillBoundary_nowait();
+            FabArrayBase::use_persistent_fb = false;
+            b.FillBoundary(geom.periodicity());
+            c.ParallelCopy(b, 0, 0, 2, 0, ng, geom.periodicity());
+            FabArrayBase::use_persistent_fb = true;
+            s.FillBoundary_finish();
+            a.FillBoundary_finish();
+            b.FillBoundary(0, 1, geom.periodicity());
+
+            // Ordinary calls only
+            FabArrayBase::use_persistent_fb = false;
+            aref.FillBoundary(geom.periodicity());
+            sref.FillBoundary();
+            bref.FillBoundary(geom.periodicity());
+            cref.ParallelCopy(bref, 0, 0, 2, 0, ng, geom.periodicity());
+            bref.FillBoundary(0, 1, geom.periodicity());
+
+            diff = std::max({diff, maxdiff(a,aref), maxdiff(b,bref), maxdiff(c,cref),
+                             maxdiff(s,sref)});
+        }
+
+        FabArrayBase::use_persistent_fb = use_persistent_fb;
+        ParallelDescriptor::m_MaxTag = max_tag;
+
+        amrex::Print() << "max difference with persistent requests: " << diff << "\n";
+        AMREX_ALWAYS_ASSERT(diff == 0.);
+    }
+    amrex::Finalize();
+}
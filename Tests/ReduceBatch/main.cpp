@@ -0,0 +1,133 @@
+//
+// Reduce sums, maxima and minima of Real, int and Long values, mixed in
+// one ReduceBatch, together with element-wise reductions of arrays and
+// the tuple of a ReduceOps/ReduceData pair, and compare each result with
+// the blocking ParallelDescriptor::Reduce* functions.  The non-blocking
+// IReduce functions are compared in the same way.
+//
+// The Real values are multiples of 1/4, so that their sums are exact in
+// any order.  The Long values do not fit into 32 bits.
+//
+
+#include <AMReX.H>
+#include <AMReX_ParallelDescriptor.H>
+#include <AMReX_Print.H>
+#include <AMReX_Reduce.H>
+#include <AMReX_ReduceBatch.H>
+
+using namespace amrex;
+
+namespace {
+
+int nfail = 0;
+
+template <typename T>
+void check (T result, T expected, char const* what)
+{
+    if (result != expected) {
+        ++nfail;
+        amrex::AllPrint() << "Proc. " << ParallelDescriptor::MyProc() << ": " << what
+                          << " is " << result << ", expected " << expected << "\n";
+    }
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        const int myproc = ParallelDescriptor::MyProc();
+        // Different orders on different processes, so that the maxima and
+        // minima are not all on the same process
+        const int sign = (myproc % 2 == 0) ? 1 : -1;
+        const Real r = Real(0.25) * (3*myproc + 1) * sign;
+        const int  i = 7*myproc - 3;
+        const Long l = (Long(1) << 40) * (myproc + 1) * sign + myproc;
+        const Real ra[3] = {r, -2*r, Real(0.5)*myproc};
+        const Long la[2] = {l, -l+1};
+
+        ReduceOps<ReduceOpSum, ReduceOpMax, ReduceOpMin> reduce_op;
+        ReduceData<Real, int, Long> reduce_data(reduce_op);
+        using ReduceTuple = typename decltype(reduce_data)::Type;
+        reduce_op.eval(4, reduce_data, [=] (int n) -> ReduceTuple
+        {
+            return {r*n, i*n, l-n};
+        });
+
+        for (int pass = 0; pass < 2; ++pass)
+        {
+            // The same batch is used twice.  In the second pass, the
+            // futures are tested until the batch, which is not posted
+            // explicitly, has finished.
+            ReduceBatch batch;
+            auto rsum = batch.Sum(r);
+            auto rmax = batch.Max(r);
+            auto rmin = batch.Min(r);
+            auto isum = batch.Sum(i);
+            auto imax = batch.Max(i);
+            auto imin = batch.Min(i);
+            auto lsum = batch.Sum(l);
+            auto lmax = batch.Max(l);
+            auto lmin = batch.Min(l);
+            auto rasum = batch.Sum(ra, 3);
+            auto lamax = batch.Max(la, 2);
+            auto tuple = batch.Add(reduce_op, reduce_data);
+            AMREX_ALWAYS_ASSERT(batch.size() == 9 + 3 + 2 + 3);
+            if (pass == 0) {
+                batch.Post();
+                AMREX_ALWAYS_ASSERT(batch.size() == 0);
+            } else {
+                while (!lmin.test()) {}
+            }
+
+            Real x = r;
+            ParallelDescriptor::ReduceRealSum(x);  check(rsum.get(), x, "Real sum");
+            x = r; ParallelDescriptor::ReduceRealMax(x);  check(rmax.get(), x, "Real max");
+            x = r; ParallelDescriptor::ReduceRealMin(x);  check(rmin.get(), x, "Real min");
+            int n = i; ParallelDescriptor::ReduceIntSum(n);  check(isum.get(), n, "int sum");
+            n = i; ParallelDescriptor::ReduceIntMax(n);  check(imax.get(), n, "int max");
+            n = i; ParallelDescriptor::ReduceIntMin(n);  check(imin.get(), n, "int min");
+            Long m = l; ParallelDescriptor::ReduceLongSum(m);  check(lsum.get(), m, "Long sum");
+            m = l; ParallelDescriptor::ReduceLongMax(m);  check(lmax.get(), m, "Long max");
+            m = l; ParallelDescriptor::ReduceLongMin(m);  check(lmin.get(), m, "Long min");
+
+            Real xa[3] = {ra[0], ra[1], ra[2]};
+            ParallelDescriptor::ReduceRealSum(xa, 3);
+            AMREX_ALWAYS_ASSERT(rasum.values().size() == 3);
+            for (int k = 0; k < 3; ++k) { check(rasum.values()[k], xa[k], "Real array sum"); }
+            Long ma[2] = {la[0], la[1]};
+            ParallelDescriptor::ReduceLongMax(ma, 2);
+            AMREX_ALWAYS_ASSERT(lamax.values().size() == 2);
+            for (int k = 0; k < 2; ++k) { check(lamax.values()[k], ma[k], "Long array max"); }
+
+            ReduceTuple hv = reduce_data.value();
+            x = amrex::get<0>(hv); ParallelDescriptor::ReduceRealSum(x);
+            n = amrex::get<1>(hv); ParallelDescriptor::ReduceIntMax(n);
+            m = amrex::get<2>(hv); ParallelDescriptor::ReduceLongMin(m);
+            const ReduceTuple t = tuple.get();
+            check(amrex::get<0>(t), x, "ReduceOps sum");
+            check(amrex::get<1>(t), n, "ReduceOps max");
+            check(amrex::get<2>(t), m, "ReduceOps min");
+        }
+
+        {
+            auto rsum = ParallelDescriptor::IReduceRealSum(r);
+            auto imin = ParallelDescriptor::IReduceIntMin(i);
+            auto lmax = ParallelDescriptor::IReduceLongMax(la, 2);
+            Real x = r;  ParallelDescriptor::ReduceRealSum(x);
+            int n = i;   ParallelDescriptor::ReduceIntMin(n);
+            Long ma[2] = {la[0], la[1]};
+            ParallelDescriptor::ReduceLongMax(ma, 2);
+            check(rsum.get(), x, "IReduceRealSum");
+            check(imin.get(), n, "IReduceIntMin");
+            check(lmax.values()[0], ma[0], "IReduceLongMax");
+            check(lmax.values()[1], ma[1], "IReduceLongMax");
+        }
+
+        ParallelDescriptor::ReduceIntSum(nfail);
+        amrex::Print() << nfail << " wrong results\n";
+        AMREX_ALWAYS_ASSERT(nfail == 0);
+    }
+    amrex::Finalize();
+}
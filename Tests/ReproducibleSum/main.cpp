@@ -0,0 +1,317 @@
+//
+// Compare MultiFab::sum and MultiFab::Dot with ordinary floating-point
+// sums and with amrex.reproducible_sums, for the same data cut into boxes
+// of different sizes.
+//
+// The data span many orders of magnitude, so the ordinary sums depend on
+// the order of the additions, i.e., on the box decomposition and on the
+// numbers of processes and threads.  The reproducible sums must be
+// bitwise identical for all the decompositions.  They are printed as
+// hexadecimal floats to compare runs with different numbers of processes
+// and threads.  The times are per call, and the overhead is the ratio of
+// the reproducible to the ordinary time.
+//
+// The sum is also computed with ReduceOps<ReduceOpReproducibleSum> in an
+// OpenMP parallel MFIter loop over tiles, which must give the same bits.
+//
+// The reproducible sums must also be correctly rounded.  They are checked
+// against known exact results: large terms that cancel exactly, leaving a
+// positive or negative integer that ordinary sums lose, sums of subnormal
+// numbers, rounding ties and sticky bits, and infinities and NaNs.  The
+// sums of a ReduceBatch are checked in the same way.
+//
+
+#include <AMReX.H>
+#include <AMReX_MultiFab.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Reduce.H>
+#include <AMReX_ReduceBatch.H>
+#include <AMReX_ReproducibleSum.H>
+#include <AMReX_Utility.H>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <string>
+
+using namespace amrex;
+
+namespace {
+
+std::string hex (Real x)
+{
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "%a", static_cast<double>(x));
+    return std::string(buf);
+}
+
+struct Result
+{
+    Real sum = 0., dot = 0.;
+    double tsum = 0., tdot = 0.;
+};
+
+Result run (MultiFab const& x, MultiFab const& y, int ntrials)
+{
+    Result r;
+    r.sum = x.sum(0);
+    r.dot = MultiFab::Dot(x, 0, y, 0, 1, 0);
+
+    double t = amrex::second();
+    for (int i = 0; i < ntrials; ++i) { r.sum = x.sum(0); }
+    r.tsum = (amrex::second() - t) / ntrials;
+
+    t = amrex::second();
+    for (int i = 0; i < ntrials; ++i) { r.dot = MultiFab::Dot(x, 0, y, 0, 1, 0); }
+    r.tdot = (amrex::second() - t) / ntrials;
+
+    return r;
+}
+
+Real reduceops_sum (MultiFab const& x)
+{
+    ReduceOps<ReduceOpReproducibleSum> reduce_op;
+    ReduceData<ReproducibleSum> reduce_data(reduce_op);
+    using ReduceTuple = typename decltype(reduce_data)::Type;
+#ifdef AMREX_USE_OMP
+#pragma omp parallel
+#endif
+    for (MFIter mfi(x, MFItInfo().EnableTiling(IntVect(8))); mfi.isValid(); ++mfi) {
+        auto const& a = x.const_array(mfi);
+        reduce_op.eval(mfi.tilebox(), reduce_data,
+                       [=] (int i, int j, int k) -> ReduceTuple { return {a(i,j,k)}; });
+    }
+    ReproducibleSum s = amrex::get<0>(reduce_data.value());
+    s.ParallelSum(ParallelContext::CommunicatorSub());
+    return static_cast<Real>(s.value());
+}
+
+bool check (double result, double expected, char const* what)
+{
+    const bool ok = (std::isnan(expected)) ? std::isnan(result)
+        : (std::memcmp(&result, &expected, sizeof(double)) == 0);
+    if (!ok) {
+        amrex::Print() << what << ": " << hex(result) << ", expected " << hex(expected) << "\n";
+    }
+    return ok;
+}
+
+bool check_exact (Box const& domain, int max_grid_size)
+{
+    bool ok = true;
+
+    BoxArray ba(domain);
+    ba.maxSize(max_grid_size);
+    DistributionMapping dm(ba);
+    MultiFab x(ba, dm, 1, 0), one(ba, dm, 1, 0);
+    one.setVal(1.0);
+    const auto ncells = static_cast<double>(domain.numPts());
+
+    // The terms repeat along i with period 4: big, small1, -big, small2.
+    // The domain length in i is a multiple of 4, so the big terms cancel.
+    const auto fill = [&] (Real big, Real small1, Real small2)
+    {
+        for (MFIter mfi(x); mfi.isValid(); ++mfi) {
+            auto const& a = x.array(mfi);
+            amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+            {
+                const int m = i % 4;
+                a(i,j,k) = (m == 0) ? big : (m == 1) ? small1 : (m == 2) ? -big : small2;
+            });
+        }
+    };
+
+    const Real big = std::ldexp(Real(1.), 70);
+    fill(big, 3., -1.);
+    ok = check(x.sum(0), ncells/2, "cancelling terms, positive total") && ok;
+    ok = check(MultiFab::Dot(x, 0, one, 0, 1, 0), ncells/2, "dot of cancelling terms") && ok;
+    ok = check(reduceops_sum(x), ncells/2, "ReduceOps cancelling terms") && ok;
+    fill(big, 1., -3.);
+    ok = check(x.sum(0), -ncells/2, "cancelling terms, negative total") && ok;
+    fill(big, -1., 1.);
+    ok = check(x.sum(0), 0., "terms cancelling to zero") && ok;
+
+    const Real tiny = std::numeric_limits<Real>::denorm_min();
+    x.setVal(tiny);
+    ok = check(x.sum(0), ncells*tiny, "subnormal terms") && ok;
+    x.setVal(-tiny);
+    ok = check(x.sum(0), -ncells*tiny, "negative subnormal terms") && ok;
+
+    const Real inf = std::numeric_limits<Real>::infinity();
+    const Real nan = std::numeric_limits<Real>::quiet_NaN();
+    const auto set_first = [&] (Real v, int which)
+    {
+        // The first cell of box 0 or of the last box
+        const int ibox = (which == 0) ? 0 : ba.size()-1;
+        for (MFIter mfi(x); mfi.isValid(); ++mfi) {
+            if (mfi.index() == ibox) {
+                const Box& bx = mfi.validbox();
+                x[mfi](bx.smallEnd()) = v;
+            }
+        }
+    };
+    x.setVal(1.0);
+    set_first(inf, 0);
+    ok = check(x.sum(0), inf, "+inf") && ok;
+    set_first(-inf, 1);
+    ok = check(x.sum(0), (ba.size() > 1) ? nan : -inf, "+inf and -inf") && ok;
+    x.setVal(-1.0);
+    set_first(-inf, 1);
+    ok = check(x.sum(0), -inf, "-inf") && ok;
+    set_first(nan, 0);
+    ok = check(x.sum(0), nan, "NaN") && ok;
+
+    return ok;
+}
+
+//! Sums over processes of a ReduceBatch, mixed with a maximum
+bool check_batch ()
+{
+    const int nprocs = ParallelDescriptor::NProcs();
+    // Large terms that cancel on some processes, and a small one
+    const auto term = [] (int p, int n) -> Real {
+        const Real big = std::ldexp(Real(1.), 70 + n);
+        switch (p % 4) {
+        case 0:  return big;
+        case 1:  return Real(1.);
+        case 2:  return -big;
+        default: return Real(0.25)*(n+1);
+        }
+    };
+    const int myproc = ParallelDescriptor::MyProc();
+    const Real mine[2] = {term(myproc,0), term(myproc,1)};
+
+    ReduceBatch batch;
+    auto fmax = batch.Max(mine[0]);
+    auto fsum = batch.Sum(mine, 2);
+    batch.Post();
+
+    bool ok = check(fmax.get(), term(0,0), "ReduceBatch max");
+    for (int n = 0; n < 2; ++n) {
+        ReproducibleSum expected;
+        for (int p = 0; p < nprocs; ++p) { expected += term(p,n); }
+        ok = check(fsum.values()[n], expected.value(), "ReduceBatch sum") && ok;
+    }
+    return ok;
+}
+
+//! Rounding of the sum to double, which does not depend on the decomposition
+bool check_rounding ()
+{
+    bool ok = true;
+    const double u = std::ldexp(1.0, -53);  // half an ulp of 1
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        ReproducibleSum a(sign*1.0);
+        a += sign*u;
+        ok = check(a.value(), sign*1.0, "tie rounded to even") && ok;
+        a += sign*u;
+        ok = check(a.value(), sign*(1.0+2*u), "two half ulps") && ok;
+        ReproducibleSum b(sign*1.0);
+        b += sign*u;
+        b += sign*std::ldexp(1.0, -300);
+        ok = check(b.value(), sign*(1.0+2*u), "tie broken by a sticky bit") && ok;
+        ReproducibleSum c(sign*std::numeric_limits<double>::max());
+        c += sign*std::numeric_limits<double>::max();
+        ok = check(c.value(), sign*std::numeric_limits<double>::infinity(), "overflow") && ok;
+    }
+    return ok;
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int n_cell = 128;
+        int ntrials = 10;
+        Vector<int> max_grid_size{64, 32, 16};
+        {
+            ParmParse pp;
+            pp.query("n_cell", n_cell);
+            pp.query("ntrials", ntrials);
+            pp.queryarr("max_grid_size", max_grid_size);
+        }
+
+        const Box domain(IntVect(0), IntVect(n_cell-1));
+
+        amrex::Print() << "\n" << domain.numPts() << " cells, "
+                       << ParallelDescriptor::NProcs() << " processes\n\n"
+                       << std::setw(6) << "mgs" << std::setw(8) << " "
+                       << std::setw(26) << "sum" << std::setw(26) << "dot"
+                       << std::setw(14) << "t_sum" << std::setw(14) << "t_dot" << "\n";
+
+        const int use_reproducible_sums = ParallelDescriptor::use_reproducible_sums;
+
+        Real repro_sum = 0., repro_dot = 0.;
+        double tsum[2] = {0.,0.}, tdot[2] = {0.,0.};
+        bool reproducible = true;
+
+        for (int ig = 0; ig < max_grid_size.size(); ++ig)
+        {
+            BoxArray ba(domain);
+            ba.maxSize(max_grid_size[ig]);
+            DistributionMapping dm(ba);
+            MultiFab x(ba, dm, 1, 0), y(ba, dm, 1, 0);
+            for (MFIter mfi(x); mfi.isValid(); ++mfi) {
+                auto const& xa = x.array(mfi);
+                auto const& ya = y.array(mfi);
+                amrex::LoopOnCpu(mfi.validbox(), [=] (int i, int j, int k) noexcept
+                {
+                    const Real scale = std::pow(Real(10.), (i+2*j+3*k)%17 - 8);
+                    xa(i,j,k) = std::sin(Real(0.1)*i + Real(0.2)*j + Real(0.3)*k) * scale;
+                    ya(i,j,k) = std::cos(Real(0.3)*i + Real(0.1)*j + Real(0.2)*k);
+                });
+            }
+
+            for (int repro = 0; repro < 2; ++repro)
+            {
+                ParallelDescriptor::use_reproducible_sums = repro;
+                const Result r = run(x, y, ntrials);
+                tsum[repro] += r.tsum;
+                tdot[repro] += r.tdot;
+
+                amrex::Print().SetPrecision(4)
+                    << std::setw(6) << max_grid_size[ig]
+                    << std::setw(8) << (repro ? "repro" : "plain")
+                    << std::setw(26) << hex(r.sum) << std::setw(26) << hex(r.dot)
+                    << std::setw(14) << r.tsum << std::setw(14) << r.tdot << "\n";
+
+                if (repro) {
+                    const Real rsum = reduceops_sum(x);
+                    if (rsum != r.sum) {
+                        amrex::Print() << "ReduceOps sum " << hex(rsum) << " differs\n";
+                        reproducible = false;
+                    }
+                    if (ig == 0) {
+                        repro_sum = r.sum;
+                        repro_dot = r.dot;
+                    } else if (r.sum != repro_sum || r.dot != repro_dot) {
+                        reproducible = false;
+                    }
+                }
+            }
+        }
+
+        ParallelDescriptor::use_reproducible_sums = 1;
+        bool exact = check_rounding() && check_batch();
+        const Box exact_domain(IntVect(0), IntVect(4*std::max(n_cell/4,1)-1));
+        for (int ig = 0; ig < max_grid_size.size(); ++ig) {
+            exact = check_exact(exact_domain, max_grid_size[ig]) && exact;
+        }
+
+        ParallelDescriptor::use_reproducible_sums = use_reproducible_sums;
+
+        amrex::Print().SetPrecision(3)
+            << "\noverhead of the reproducible sums: sum " << tsum[1]/tsum[0]
+            << "x, dot " << tdot[1]/tdot[0] << "x\n";
+
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(reproducible,
+                                         "reproducible sums differ between decompositions");
+        AMREX_ALWAYS_ASSERT_WITH_MESSAGE(exact, "reproducible sums are not exact");
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,240 @@
+//
+// Check the sweeps used by BoxList::complementIn, parallelComplementIn and
+// simplify against the original algorithms on random BoxArrays.
+//
+// The BoxArrays have random boxes that may overlap, or are made by
+// chopping the domain and dropping some of the pieces.  The results of
+// the sweeps must be inside the box, must not intersect the BoxArray, and
+// must cover the same cells as the results of the original algorithms.
+//
+
+#include <AMReX.H>
+#include <AMReX_BoxArray.H>
+#include <AMReX_BoxList.H>
+#include <AMReX_ParmParse.H>
+#include <AMReX_Print.H>
+#include <AMReX_Utility.H>
+
+#include <iomanip>
+#include <random>
+
+using namespace amrex;
+
+namespace {
+
+std::mt19937 gen(7);
+
+int rand_int (int lo, int hi)
+{
+    std::uniform_int_distribution<int> dist(lo, hi);
+    return dist(gen);
+}
+
+Box rand_box (const Box& domain, int max_len)
+{
+    IntVect lo, hi;
+    for (int d = 0; d < AMREX_SPACEDIM; ++d) {
+        lo[d] = rand_int(domain.smallEnd(d), domain.bigEnd(d));
+        hi[d] = std::min(domain.bigEnd(d), lo[d] + rand_int(0, max_len-1));
+    }
+    return Box(lo, hi);
+}
+
+BoxArray make_overlapping (const Box& domain, int nboxes, int max_len)
+{
+    BoxList bl;
+    for (int i = 0; i < nboxes; ++i) {
+        bl.push_back(rand_box(domain, max_len));
+    }
+    return BoxArray(std::move(bl));
+}
+
+BoxArray make_disjoint (const Box& domain, int max_grid_size, Real keep)
+{
+    BoxList chopped(domain);
+    chopped.maxSize(max_grid_size);
+    BoxList bl;
+    std::uniform_real_distribution<Real> dist(0., 1.);
+    for (auto const& b : chopped) {
+        if (dist(gen) < keep) {
+            // Trim some boxes so that they do not line up.
+            Box bx = b;
+            if (dist(gen) < 0.3) {
+                int d = rand_int(0, AMREX_SPACEDIM-1);
+                bx.setBig(d, bx.smallEnd(d) + rand_int(0, bx.length(d)-1));
+            }
+            bl.push_back(bx);
+        }
+    }
+    return BoxArray(std::move(bl));
+}
+
+// Is every cell of bl_ref in bl?
+bool covers (const BoxList& bl, const BoxList& bl_ref)
+{
+    if (bl.isEmpty()) return bl_ref.isEmpty();
+    BoxArray ba(bl);
+    for (auto const& b : bl_ref) {
+        if (!ba.contains(b, false)) return false;
+    }
+    return true;
+}
+
+// Does bl cover the same cells as bl_ref without overlaps?  The blocks
+// used by complementIn overlap on their faces if the boxes are not
+// cell-centered, so that is only checked for cell-centered boxes.
+bool same_cells (const BoxList& bl, const BoxList& bl_ref)
+{
+    if (!covers(bl, bl_ref) || !covers(bl_ref, bl)) return false;
+    return !bl.ixType().cellCentered() || bl.isEmpty() || BoxArray(bl).isDisjoint();
+}
+
+bool is_complement (const BoxList& bl, const BoxList& bl_ref, const Box& b, const BoxArray& ba)
+{
+    for (auto const& bx : bl) {
+        if (!b.contains(bx) || ba.intersects(bx)) return false;
+    }
+    return same_cells(bl, bl_ref);
+}
+
+struct Stats
+{
+    Long nboxes_old = 0;
+    Long nboxes_new = 0;
+    double t_old = 0.;
+    double t_new = 0.;
+};
+
+bool check (const std::string& name, const Box& b, const BoxArray& ba, Stats& cstats,
+            Stats& sstats)
+{
+    bool ok = true;
+
+    BoxList bl_old, bl_new;
+    {
+        BoxList::sweep_threshold = -1;
+        double t = amrex::second();
+        bl_old.complementIn(b, ba);
+        cstats.t_old += amrex::second() - t;
+    }
+    {
+        BoxList::sweep_threshold = 0;
+        double t = amrex::second();
+        bl_new.complementIn(b, ba);
+        cstats.t_new += amrex::second() - t;
+    }
+    cstats.nboxes_old += bl_old.size();
+    cstats.nboxes_new += bl_new.size();
+
+    if (!is_complement(bl_new, bl_old, b, ba)) {
+        amrex::Print() << "  " << name << ": complementIn differs\n";
+        ok = false;
+    }
+
+    {
+        BoxList bl_par;
+        bl_par.parallelComplementIn(b, ba);
+        if (!is_complement(bl_par, bl_old, b, ba)) {
+            amrex::Print() << "  " << name << ": parallelComplementIn differs\n";
+            ok = false;
+        }
+    }
+
+    BoxList bs_old = bl_old, bs_new = bl_old;
+    {
+        BoxList::sweep_threshold = -1;
+        double t = amrex::second();
+        bs_old.simplify();
+        sstats.t_old += amrex::second() - t;
+    }
+    {
+        BoxList::sweep_threshold = 0;
+        double t = amrex::second();
+        bs_new.simplify();
+        sstats.t_new += amrex::second() - t;
+    }
+    sstats.nboxes_old += bs_old.size();
+    sstats.nboxes_new += bs_new.size();
+
+    if (!same_cells(bs_new, bl_old) || !same_cells(bs_old, bl_old)) {
+        amrex::Print() << "  " << name << ": simplify changed the cells\n";
+        ok = false;
+    }
+
+    return ok;
+}
+
+void report (const std::string& name, const Stats& s)
+{
+    amrex::Print() << std::setw(14) << name
+                   << std::setw(12) << s.nboxes_old << std::setw(12) << s.nboxes_new
+                   << std::setw(12) << s.t_old << std::setw(12) << s.t_new << "\n";
+}
+
+}
+
+int main (int argc, char* argv[])
+{
+    amrex::Initialize(argc,argv);
+    {
+        int ntrials = 100;
+        int n_cell = 128;
+        int nboxes = 1000;
+        int max_grid_size = 16;
+        {
+            ParmParse pp;
+            pp.query("ntrials", ntrials);
+            pp.query("n_cell", n_cell);
+            pp.query("nboxes", nboxes);
+            pp.query("max_grid_size", max_grid_size);
+        }
+
+        const int threshold_save = BoxList::sweep_threshold;
+
+        Box domain(IntVect(0), IntVect(n_cell-1));
+        Stats cstats, sstats;
+        int nfailed = 0;
+
+        for (int trial = 0; trial < ntrials; ++trial)
+        {
+            const int n = rand_int(2, nboxes);
+            const int len = rand_int(1, max_grid_size*2);
+
+            BoxArray ba = (trial % 2 == 0)
+                ? make_overlapping(domain, n, len)
+                : make_disjoint(domain, rand_int(1, max_grid_size), rand_int(1,9)/Real(10.));
+
+            // Every process must use the same random numbers.
+            Box b = amrex::grow(domain, rand_int(-n_cell/4, 2));
+            if (trial % 3 == 0) {
+                b = rand_box(domain, n_cell);
+            }
+
+            const std::string name = "trial " + std::to_string(trial);
+            bool ok = ba.empty() || check(name, b, ba, cstats, sstats);
+
+            if (ok && trial % 5 == 0 && !ba.empty()) {
+                // Nodal and mixed index types
+                IndexType typ = (trial % 10 == 0) ? IndexType::TheNodeType()
+                                                  : IndexType(IntVect::TheDimensionVector(0));
+                BoxArray ba2(ba);
+                ba2.convert(typ);
+                ok = check(name + " converted", amrex::convert(b,typ), ba2, cstats, sstats);
+            }
+
+            if (!ok) ++nfailed;
+        }
+
+        amrex::Print() << "\n" << std::setw(14) << " "
+                       << std::setw(12) << "# old" << std::setw(12) << "# sweep"
+                       << std::setw(12) << "t old" << std::setw(12) << "t sweep" << "\n";
+        report("complementIn", cstats);
+        report("simplify", sstats);
+        amrex::Print() << "\n" << ntrials-nfailed << " of " << ntrials << " trials passed\n";
+
+        BoxList::sweep_threshold = threshold_save;
+
+        AMREX_ALWAYS_ASSERT(nfailed == 0);
+    }
+    amrex::Finalize();
+}
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+
+# Read the binary memory trace written with fabarray.mem_trace = 1 and
+# print the high water mark of each tag and Arena, the step at which each
+# of them peaked, and the histograms of the sizes of the allocations of
+# each Arena per region tag.
+#
+# Usage: parsememtrace.py mem_trace.0 [mem_trace.1 ...]
+
+import struct
+import sys
+
+
+def read_trace(fname):
+  with open(fname, 'rb') as f:
+    data = f.read()
+
+  pos = [0]
+
+  def read(fmt):
+    r = struct.unpack_from(fmt, data, pos[0])
+    pos[0] += struct.calcsize(fmt)
+    return r
+
+  magic = data[0:8]
+  if magic != b'AMRXMTR2':
+    raise RuntimeError("%s is not an AMReX memory trace" % fname)
+  pos[0] = 8
+
+  rank, nprocs = read('=ii')
+  nnames, = read('=i')
+  names = []
+  for i in range(nnames):
+    n, = read('=i')
+    names.append(data[pos[0]:pos[0]+n].decode())
+    pos[0] += n
+
+  hwm = [read('=q')[0] for i in range(nnames)]
+
+  nhists, = read('=i')
+  hists = []
+  for i in range(nhists):
+    tag, arena = read('=ii')
+    hists.append((tag, arena, read('=64q')))
+
+  nrecords, = read('=q')
+  records = []
+  for i in range(nrecords):
+    step, time, nentries = read('=qdi')
+    entries = [read('=iqq') for e in range(nentries)]
+    records.append((step, time, entries))
+
+  return rank, names, hwm, hists, records
+
+
+def main():
+  if len(sys.argv) < 2:
+    print("Usage: %s mem_trace.0 [mem_trace.1 ...]" % sys.argv[0])
+    sys.exit(1)
+
+  for fname in sys.argv[1:]:
+    rank, names, hwm, hists, records = read_trace(fname)
+    print("rank %d" % rank)
+    for i, name in enumerate(names):
+      peak_step, peak = None, -1
+      for step, time, entries in records:
+        for e in entries:
+          if e[0] == i and e[2] > peak:
+            peak_step, peak = step, e[2]
+      print("  %-40s hwm %14d bytes, peaked in step %s" % (name, hwm[i], peak_step))
+    for tag, arena, hist in hists:
+      print("  allocations in %s under tag %s" % (names[arena], names[tag]))
+      for b, n in enumerate(hist):
+        if n > 0:
+          print("      [2^%2d, 2^%2d) bytes: %d allocations" % (b, b+1, n))
+
+
+if __name__ == "__main__":
+  main()